@@ -11,6 +11,8 @@
 using DSO.AST.Nodes;
 using DSO.ControlFlow;
 using DSO.Disassembler;
+using System.Collections.Concurrent;
+using System.Runtime.InteropServices;
 
 namespace DSO.AST
 {
@@ -21,6 +23,29 @@ namespace DSO.AST
 		public BuilderException(string message, Exception inner) : base(message, inner) { }
 	}
 
+	/// <summary>
+	/// Keeps builders around after they're done so their stacks can be reused by the next file. Safe to share
+	/// between threads.
+	/// </summary>
+	public class BuilderPool
+	{
+		private readonly ConcurrentBag<Builder> _builders = [];
+
+		public T Use<T>(Func<Builder, T> run)
+		{
+			var builder = _builders.TryTake(out Builder? pooled) ? pooled : new();
+
+			try
+			{
+				return run(builder);
+			}
+			finally
+			{
+				_builders.Add(builder);
+			}
+		}
+	}
+
 	/// <summary>
 	/// This place is not a place of honor. Nothing is valued here.
 	///
@@ -29,25 +54,49 @@ namespace DSO.AST
 	/// The danger is still present in your time, as it was in ours.
 	/// The danger is to the mind and it can kill.
 	///
-	/// This place is best shunned and left uninhabited.
+	/// This place is best shunned and left uninhabited.<br/><br/>
+	///
+	/// A builder can be reused for as many files as you want (one at a time). Every range in a file is built on the
+	/// same node stack, and the stack and argument frames are kept around between files so they don't have to be
+	/// allocated again. The lists that ranges end up in come from a <see cref="NodeListArena"/> if there is one.
 	/// </summary>
 	public class Builder
 	{
-		private Disassembly _disassembly = new();
-		private ControlFlowData _data = new();
+		/// <summary>
+		/// What an idle builder points at, so that it doesn't keep the last file it built alive.
+		/// </summary>
+		static private readonly Disassembly _emptyDisassembly = new(codeSize: 0);
+		static private readonly ControlFlowData _emptyData = new();
+
+		private Disassembly _disassembly = _emptyDisassembly;
+		private ControlFlowData _data = _emptyData;
 		private Instruction? _currentInstruction = null;
 		private uint _endAddress = 0;
 		private bool _running = false;
 		private int _objectDepth = 0;
-		private Stack<List<Node>> _frameStack = [];
-		private Stack<Node> _nodeStack = [];
+
+		/// <summary>
+		/// Where the range we're currently building starts in <see cref="_nodeStack"/>. Nothing below it can be popped.
+		/// </summary>
+		private int _stackBase = 0;
+
+		private readonly Stack<List<Node>> _frameStack = [];
+		private readonly Stack<List<Node>> _framePool = [];
+		private readonly List<Node> _nodeStack = [];
+
+		/// <summary>
+		/// Function bodies that were already built by the <see cref="ParallelBuilder"/>, by function address.
+		/// </summary>
+		private Dictionary<uint, List<Node>>? _functionBodies = null;
+
+		private NodeListArena? _arena = null;
 
 		public uint CurrentAddress => _currentInstruction?.Address ?? 0;
 		private bool IsAtEnd => !_running || _currentInstruction == null || _currentInstruction.Address > _endAddress;
 
-		public List<Node> Build(ControlFlowData data, Disassembly disassembly)
+		public List<Node> Build(ControlFlowData data, Disassembly disassembly, Dictionary<uint, List<Node>>? functionBodies = null, NodeListArena? arena = null)
 		{
-			var list = Build(data, disassembly, disassembly.First.Address, disassembly.Last.Address);
+			var list = Build(data, disassembly, disassembly.First.Address, disassembly.Last.Address, functionBodies, arena);
 
 			// Like with function declarations, a return statement automatically gets put at the ends of files, so we remove it.
 			if (list.Count > 0 && list.Last() is ReturnNode ret && ret.Value == null)
@@ -58,29 +107,43 @@ namespace DSO.AST
 			return list;
 		}
 
-		public List<Node> Build(ControlFlowData data, Disassembly disassembly, uint startAddress, uint endAddress)
+		public List<Node> Build(ControlFlowData data, Disassembly disassembly, uint startAddress, uint endAddress, Dictionary<uint, List<Node>>? functionBodies = null, NodeListArena? arena = null)
 		{
 			_disassembly = disassembly;
 			_data = data;
+			_functionBodies = functionBodies;
+			_arena = arena;
 			_currentInstruction = disassembly.GetInstruction(startAddress);
 			_endAddress = endAddress;
 			_objectDepth = 0;
-			_frameStack = [];
-			_nodeStack = [];
-
-			Build();
-
-			List<Node> list = [.._nodeStack];
-
-			list.Reverse();
+			_stackBase = 0;
+			_frameStack.Clear();
+			_nodeStack.Clear();
+			_running = true;
 
-			return list;
+			try
+			{
+				return Build();
+			}
+			finally
+			{
+				// Don't hold onto the last file, since builders sit in a pool for as long as the decompiler is around.
+				_disassembly = _emptyDisassembly;
+				_data = _emptyData;
+				_functionBodies = null;
+				_arena = null;
+				_currentInstruction = null;
+				_nodeStack.Clear();
+				_frameStack.Clear();
+				_running = false;
+			}
 		}
 
-		private void Build()
+		/// <summary>
+		/// Builds everything up to <see cref="_endAddress"/> on top of the node stack, then moves it off into a list.
+		/// </summary>
+		private List<Node> Build()
 		{
-			_running = true;
-
 			while (!IsAtEnd)
 			{
 				var node = Parse(Read());
@@ -90,6 +153,14 @@ namespace DSO.AST
 					Push(node);
 				}
 			}
+
+			var count = _nodeStack.Count - _stackBase;
+			var list = RentList(count);
+
+			list.AddRange(CollectionsMarshal.AsSpan(_nodeStack).Slice(_stackBase, count));
+			_nodeStack.RemoveRange(_stackBase, count);
+
+			return list;
 		}
 
 		protected virtual Node? Parse(Instruction? instruction)
@@ -119,10 +190,9 @@ namespace DSO.AST
 							True = body,
 						};
 
-						if (block.End is BranchInstruction branch && branch.IsUnconditional && _data.Branches[branch.Address].Type == ControlFlowBranchType.Else)
-						{
-							node.False = ParseRange(branch.Next, _disassembly.GetInstruction(branch.TargetAddress).Prev);
-						}
+						node.False = block.End is BranchInstruction branch && branch.IsUnconditional && _data.Branches[branch.Address].Type == ControlFlowBranchType.Else
+							? ParseRange(branch.Next, _disassembly.GetInstruction(branch.TargetAddress).Prev)
+							: RentList(0);
 
 						return CollapseIfLoop(node);
 					}
@@ -164,7 +234,7 @@ namespace DSO.AST
 					return null;
 
 				case PushFrameInstruction:
-					_frameStack.Push([]);
+					_frameStack.Push(_framePool.Count > 0 ? _framePool.Pop() : []);
 					return null;
 
 				case AdvanceStringInstruction:
@@ -309,7 +379,18 @@ namespace DSO.AST
 
 				case FunctionInstruction function:
 				{
-					var body = ParseRange(_currentInstruction.Address, function.EndAddress - 1);
+					List<Node> body;
+
+					if (_functionBodies != null && _functionBodies.Remove(function.Address, out List<Node>? built))
+					{
+						body = built;
+						_currentInstruction = _disassembly.GetInstruction(function.EndAddress);
+					}
+					else
+					{
+						body = ParseRange(_currentInstruction.Address, function.EndAddress - 1);
+					}
+
 					var node = new FunctionDeclarationNode(function)
 					{
 						Body = body,
@@ -343,8 +424,10 @@ namespace DSO.AST
 				case CallInstruction call:
 				{
 					var node = new FunctionCallNode(call);
+					var frame = _frameStack.Pop();
 
-					_frameStack.Pop().ForEach(node.AddArgument);
+					frame.ForEach(node.AddArgument);
+					ReleaseFrame(frame);
 
 					return node;
 				}
@@ -386,60 +469,52 @@ namespace DSO.AST
 						node.AddArgument(frame[i]);
 					}
 
+					ReleaseFrame(frame);
+
 					return node;
 				}
 
 				case AddObjectInstruction add:
 				{
-					var fields = new Stack<AssignmentNode>();
+					var start = FindRunStart(node => node is AssignmentNode);
 
-					while (Peek() is AssignmentNode)
+					if (start <= _stackBase || _nodeStack[start - 1] is not ObjectDeclarationNode obj)
 					{
-						fields.Push((AssignmentNode) Pop());
+						throw new BuilderException($"Expected object declaration before {add.Opcode.Value} at {add.Address}");
 					}
 
-					var node = Pop();
-
-					if (node is not ObjectDeclarationNode obj)
+					for (var i = start; i < _nodeStack.Count; i++)
 					{
-						throw new BuilderException($"Expected object declaration before {add.Opcode.Value} at {add.Address}");
+						obj.Fields.Add((AssignmentNode) _nodeStack[i]);
 					}
 
+					_nodeStack.RemoveRange(start - 1, _nodeStack.Count - start + 1);
+
 					if (add.PlaceAtRoot)
 					{
 						// Get rid of 0 uint immediate that gets placed before root objects.
 						Pop();
 					}
 
-					while (fields.Count > 0)
-					{
-						obj.Fields.Add(fields.Pop());
-					}
-
 					return obj;
 				}
 
 				case EndObjectInstruction end:
 				{
-					var children = new Stack<ObjectDeclarationNode>();
-
-					while (Peek() is ObjectDeclarationNode child && child.Depth == _objectDepth)
-					{
-						children.Push((ObjectDeclarationNode) Pop());
-					}
-
-					var node = Pop();
+					var start = FindRunStart(node => node is ObjectDeclarationNode child && child.Depth == _objectDepth);
 
-					if (node is not ObjectDeclarationNode obj)
+					if (start <= _stackBase || _nodeStack[start - 1] is not ObjectDeclarationNode obj)
 					{
 						throw new BuilderException($"Expected object declaration before {end.Opcode.Value} at {end.Address}");
 					}
 
-					while (children.Count > 0)
+					for (var i = start; i < _nodeStack.Count; i++)
 					{
-						obj.Children.Add(children.Pop());
+						obj.Children.Add((ObjectDeclarationNode) _nodeStack[i]);
 					}
 
+					_nodeStack.RemoveRange(start - 1, _nodeStack.Count - start + 1);
+
 					_objectDepth--;
 
 					return obj;
@@ -478,9 +553,12 @@ namespace DSO.AST
 						end = ifNode.ConvertToTernary();
 					}
 
+					// The loop gets thrown away, so its body can just be moved over.
+					loop.Body.RemoveAt(loop.Body.Count - 1);
+
 					return new ForLoopNode(Pop(), loop.Test, end)
 					{
-						Body = loop.Body[..^1],
+						Body = loop.Body,
 					};
 				}
 			}
@@ -493,21 +571,64 @@ namespace DSO.AST
 
 		private List<Node> ParseRange(Instruction from, Instruction to) => ParseRange(from.Address, to.Address);
 
+		/// <summary>
+		/// Builds a range on top of the current one, and leaves off at the end of it.
+		/// </summary>
 		private List<Node> ParseRange(uint fromAddress, uint toAddress)
 		{
-			var builder = new Builder();
-			var list = builder.Build(_data, _disassembly, fromAddress, toAddress);
+			var endAddress = _endAddress;
+			var stackBase = _stackBase;
+			var objectDepth = _objectDepth;
 
-			_currentInstruction = _disassembly.GetInstruction(builder.CurrentAddress);
+			_currentInstruction = _disassembly.GetInstruction(fromAddress);
+			_endAddress = toAddress;
+			_stackBase = _nodeStack.Count;
+			_objectDepth = 0;
+
+			var list = Build();
+
+			_endAddress = endAddress;
+			_stackBase = stackBase;
+			_objectDepth = objectDepth;
 
 			return list;
 		}
 
-		private void Push(Node node) => _nodeStack.Push(node);
+		private List<Node> RentList(int capacity) => _arena?.Rent() ?? new(capacity);
+
+		private void ReleaseFrame(List<Node> frame)
+		{
+			frame.Clear();
+			_framePool.Push(frame);
+		}
+
+		/// <summary>
+		/// Returns where the run of nodes matching <paramref name="predicate"/> at the top of the stack starts.
+		/// </summary>
+		private int FindRunStart(Func<Node, bool> predicate)
+		{
+			var start = _nodeStack.Count;
+
+			while (start > _stackBase && predicate(_nodeStack[start - 1]))
+			{
+				start--;
+			}
+
+			return start;
+		}
+
+		private void Push(Node node) => _nodeStack.Add(node);
 
 		private Node Pop()
 		{
-			var node = _nodeStack.Pop();
+			if (_nodeStack.Count <= _stackBase)
+			{
+				throw new BuilderException($"Missing expression before {CurrentAddress}");
+			}
+
+			var node = _nodeStack[^1];
+
+			_nodeStack.RemoveAt(_nodeStack.Count - 1);
 
 			if (node is IfNode ifNode)
 			{
@@ -517,7 +638,7 @@ namespace DSO.AST
 			return node;
 		}
 
-		private Node? Peek() => _nodeStack.Count > 0 ? _nodeStack.Peek() : null;
+		private Node? Peek() => _nodeStack.Count > _stackBase ? _nodeStack[^1] : null;
 
 		private Instruction? Read()
 		{
@@ -0,0 +1,103 @@
+﻿/**
+ * NodeListArena.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.AST.Nodes;
+using System.Collections.Concurrent;
+
+namespace DSO.AST
+{
+	/// <summary>
+	/// Owns the lists that hold the bodies of a file's functions, loops, and if statements while it's being built
+	/// and generated, and takes all of them back at once when the file is done. The next file then reuses the lists
+	/// and the arrays under them instead of allocating its own.<br/><br/>
+	///
+	/// Anything built with an arena is only good until the arena is reset. Safe to share between threads, since the
+	/// <see cref="ParallelBuilder"/> builds the functions of one file on several at once.
+	/// </summary>
+	public class NodeListArena
+	{
+		/// <summary>
+		/// Lists that grew bigger than this are dropped when the arena is reset, and so are any lists past the last
+		/// <see cref="MAX_RETAINED_LISTS"/>, so one huge file doesn't keep all its memory around for the rest of the
+		/// run.
+		/// </summary>
+		private const int MAX_RETAINED_CAPACITY = 256;
+		private const int MAX_RETAINED_LISTS = 16384;
+
+		private readonly List<List<Node>> _lists = [];
+		private readonly object _lock = new();
+		private int _used = 0;
+
+		public List<Node> Rent()
+		{
+			lock (_lock)
+			{
+				if (_used >= _lists.Count)
+				{
+					_lists.Add([]);
+				}
+
+				return _lists[_used++];
+			}
+		}
+
+		public void Reset()
+		{
+			lock (_lock)
+			{
+				for (var i = 0; i < _used; i++)
+				{
+					if (_lists[i].Capacity > MAX_RETAINED_CAPACITY)
+					{
+						_lists[i] = [];
+					}
+					else
+					{
+						_lists[i].Clear();
+					}
+				}
+
+				if (_lists.Count > MAX_RETAINED_LISTS)
+				{
+					_lists.RemoveRange(MAX_RETAINED_LISTS, _lists.Count - MAX_RETAINED_LISTS);
+				}
+
+				_used = 0;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Keeps arenas around between files, same as <see cref="BuilderPool"/> does with builders. Safe to share between
+	/// threads.
+	/// </summary>
+	public class NodeListArenaPool
+	{
+		private readonly ConcurrentBag<NodeListArena> _arenas = [];
+
+		/// <summary>
+		/// The arena is reset once <paramref name="run"/> returns, so nothing built with it can be returned.
+		/// </summary>
+		public T Use<T>(Func<NodeListArena, T> run)
+		{
+			var arena = _arenas.TryTake(out NodeListArena? pooled) ? pooled : new();
+
+			try
+			{
+				return run(arena);
+			}
+			finally
+			{
+				arena.Reset();
+				_arenas.Add(arena);
+			}
+		}
+	}
+}
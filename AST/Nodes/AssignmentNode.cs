@@ -29,6 +29,8 @@ namespace DSO.AST.Nodes
 
 		public override int GetHashCode() => base.GetHashCode() ^ Left.GetHashCode() ^ Right.GetHashCode() ^ (Operator?.GetHashCode() ?? 0);
 
+		public override int NodeCount => 1 + Left.NodeCount + Right.NodeCount;
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(Left, isExpression: true);
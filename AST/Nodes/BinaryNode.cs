@@ -48,6 +48,8 @@ namespace DSO.AST.Nodes
 
 		public override int GetHashCode() => base.GetHashCode() ^ Left.GetHashCode() ^ Right.GetHashCode() ^ Op.GetHashCode();
 
+		public override int NodeCount => 1 + Left.NodeCount + Right.NodeCount;
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(Left, CheckPrecedenceAndAssociativity);
@@ -35,6 +35,8 @@ namespace DSO.AST.Nodes
 
 		public override bool IsAssociativeWith(Node compare) => compare is ConcatNode;
 
+		public override int NodeCount => 1 + Left.NodeCount + (_right?.NodeCount ?? 0);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(Left, CheckPrecedenceAndAssociativity);
@@ -32,6 +32,8 @@ namespace DSO.AST.Nodes
 
 		public override int GetHashCode() => base.GetHashCode() ^ Name.GetHashCode() ^ (Object?.GetHashCode() ?? 0) ^ (Index?.GetHashCode() ?? 0);
 
+		public override int NodeCount => 1 + (Object?.NodeCount ?? 0) + (Index?.NodeCount ?? 0);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			if (Object != null)
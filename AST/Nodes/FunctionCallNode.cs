@@ -23,11 +23,16 @@ namespace DSO.AST.Nodes
 
 	public class FunctionCallNode(CallInstruction instruction) : Node(NodeType.ExpressionStatement)
 	{
+		/// <summary>
+		/// Same as checking <see cref="Enum.IsDefined"/>, but without the reflection, since it's done for every call.
+		/// </summary>
+		static public CallType GetCallType(uint callType) => callType < (uint) CallType.Invalid ? (CallType) callType : CallType.Invalid;
+
 		private readonly List<Node> _arguments = [];
 
 		public readonly string Name = instruction.Name;
 		public readonly string? Namespace = instruction.Namespace;
-		public readonly CallType CallType = Enum.IsDefined(typeof(CallType), instruction.CallType) ? (CallType) instruction.CallType : CallType.Invalid;
+		public readonly CallType CallType = GetCallType(instruction.CallType);
 
 		public void AddArgument(Node arg) => _arguments.Add(arg is ConstantStringNode node ? node.ConvertToUIntNode() ?? node.ConvertToDoubleNode() ?? arg : arg);
 
@@ -38,6 +43,8 @@ namespace DSO.AST.Nodes
 		public override int GetHashCode() => base.GetHashCode() ^ Name.GetHashCode() ^ (Namespace?.GetHashCode() ?? 0)
 			^ CallType.GetHashCode() ^ _arguments.GetHashCode();
 
+		public override int NodeCount => 1 + CountNodes(_arguments);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			var methodCall = CallType == CallType.MethodCall;
@@ -18,7 +18,9 @@ namespace DSO.AST.Nodes
 		public readonly string Name = instruction.Name;
 		public readonly string? Namespace = instruction.Namespace;
 		public readonly List<string> Arguments = [..instruction.Arguments];
-		public List<Node> Body { get; set; } = [];
+		private List<Node>? _body = null;
+
+		public List<Node> Body { get => _body ??= []; set => _body = value; }
 
 		public override bool Equals(object? obj) => base.Equals(obj) && obj is FunctionDeclarationNode node
 			&& node.Name.Equals(Name) && Equals(node.Namespace, Namespace)
@@ -27,6 +29,8 @@ namespace DSO.AST.Nodes
 		public override int GetHashCode() => base.GetHashCode() ^ Name.GetHashCode() ^ (Namespace?.GetHashCode() ?? 0)
 			^ Arguments.GetHashCode() ^ Body.GetHashCode();
 
+		public override int NodeCount => 1 + CountNodes(Body);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write("function", " ");
@@ -68,6 +72,8 @@ namespace DSO.AST.Nodes
 
 		public override int GetHashCode() => base.GetHashCode() ^ Name.GetHashCode() ^ Functions.GetHashCode();
 
+		public override int NodeCount => 1 + CountNodes(Functions);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write("package", " ", Name, "\n", "{", "\n");
@@ -14,11 +14,57 @@ namespace DSO.AST.Nodes
 {
 	public class IfNode(Node? test = null) : Node(NodeType.Statement)
 	{
-		public Node? Test { get; set; } = test;
-		public List<Node> True { get; set; } = [];
-		public List<Node> False { get; set; } = [];
+		private Node? _test = test;
+
+		/// <summary>
+		/// The builder always sets both of these itself, so they're only made here if nothing else does.
+		/// </summary>
+		private List<Node>? _true = null;
+		private List<Node>? _false = null;
+
+		/// <summary>
+		/// Both of these recurse into nested if statements and get called on the same ones over and over, which
+		/// makes long else-if chains quadratic, so they're only worked out once. Since an if statement is always
+		/// built after the ones inside it, those are already worked out by the time we get to it.<br/><br/>
+		///
+		/// Setting any part of the if statement clears them.
+		/// </summary>
+		private bool? _canConvertToTernary = null;
+		private TernaryIfNode? _ternary = null;
+
+		public Node? Test
+		{
+			get => _test;
+			set
+			{
+				_test = value;
+				ClearCache();
+			}
+		}
+
+		public List<Node> True
+		{
+			get => _true ??= [];
+			set
+			{
+				_true = value;
+				ClearCache();
+			}
+		}
+
+		public List<Node> False
+		{
+			get => _false ??= [];
+			set
+			{
+				_false = value;
+				ClearCache();
+			}
+		}
+
+		public bool CanConvertToTernary() => _canConvertToTernary ??= CheckCanConvertToTernary();
 
-		public bool CanConvertToTernary()
+		private bool CheckCanConvertToTernary()
 		{
 			if (Test == null || True.Count != 1 || False.Count != 1)
 			{
@@ -48,11 +94,19 @@ namespace DSO.AST.Nodes
 			return canConvert;
 		}
 
+		private void ClearCache()
+		{
+			_canConvertToTernary = null;
+			_ternary = null;
+		}
+
 		public override bool Equals(object? obj) => base.Equals(obj) && obj is IfNode node
 			&& Equals(node.Test, Test) && node.True.SequenceEqual(True) && node.False.SequenceEqual(False);
 
 		public override int GetHashCode() => base.GetHashCode() ^ (Test?.GetHashCode() ?? 0) ^ True.GetHashCode() ^ False.GetHashCode();
 
+		public override int NodeCount => 1 + (Test?.NodeCount ?? 0) + CountNodes(True) + CountNodes(False);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write("if", " ", "(");
@@ -83,18 +137,29 @@ namespace DSO.AST.Nodes
 			}
 		}
 
+		/// <summary>
+		/// Converting the same if statement twice gives back the same node, which is fine since ternary nodes can't be
+		/// changed once they're made.
+		/// </summary>
 		public TernaryIfNode ConvertToTernary()
 		{
+			if (_ternary != null)
+			{
+				return _ternary;
+			}
+
 			if (!CanConvertToTernary())
 			{
 				throw new InvalidCastException("Could not convert if statement to ternary expression");
 			}
 
-			return new(
-				Test,
+			_ternary = new(
+				Test!,
 				True[0] is IfNode trueIf ? trueIf.ConvertToTernary() : True[0],
 				False[0] is IfNode falseIf ? falseIf.ConvertToTernary() : False[0]
 			);
+
+			return _ternary;
 		}
 	}
 
@@ -111,6 +176,8 @@ namespace DSO.AST.Nodes
 
 		public override int GetHashCode() => base.GetHashCode() ^ Test.GetHashCode() ^ True.GetHashCode() ^ False.GetHashCode();
 
+		public override int NodeCount => 1 + Test.NodeCount + True.NodeCount + False.NodeCount;
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(Test, node => node is TernaryIfNode || node is AssignmentNode);
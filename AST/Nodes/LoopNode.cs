@@ -15,11 +15,15 @@ namespace DSO.AST.Nodes
 	public class LoopNode(Node test) : Node(NodeType.Statement)
 	{
 		public readonly Node Test = test;
-		public List<Node> Body { get; set; } = [];
+		private List<Node>? _body = null;
+
+		public List<Node> Body { get => _body ??= []; set => _body = value; }
 
 		public override bool Equals(object? obj) => base.Equals(obj) && obj is LoopNode node && node.Test.Equals(Test) && node.Body.SequenceEqual(Body);
 		public override int GetHashCode() => base.GetHashCode() ^ Test.GetHashCode() ^ Body.GetHashCode();
 
+		public override int NodeCount => 1 + Test.NodeCount + CountNodes(Body);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write("do", "\n", "{", "\n");
@@ -59,6 +63,8 @@ namespace DSO.AST.Nodes
 
 		public override int GetHashCode() => base.GetHashCode() ^ Init.GetHashCode() ^ End.GetHashCode();
 
+		public override int NodeCount => base.NodeCount + Init.NodeCount + End.NodeCount;
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write("for", " ", "(");
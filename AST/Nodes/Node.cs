@@ -22,6 +22,8 @@ namespace DSO.AST.Nodes
 
 	public abstract class Node(NodeType type)
 	{
+		static public int CountNodes(IEnumerable<Node> nodes) => nodes.Sum(node => node.NodeCount);
+
 		public NodeType Type { get; protected set; } = type;
 
 		public virtual int Precedence => 0;
@@ -37,6 +39,13 @@ namespace DSO.AST.Nodes
 		public virtual bool IsAssociativeWith(Node compare) => false;
 		public override bool Equals(object? obj) => obj is Node node && node.Type.Equals(Type);
 		public override int GetHashCode() => Type.GetHashCode();
+
+		/// <summary>
+		/// How many nodes there are in this one's subtree, counting itself. It's only for statistics, so it walks the
+		/// whole subtree every time.
+		/// </summary>
+		public virtual int NodeCount => 1;
+
 		public virtual void Visit(CodeWriter writer, bool isExpression) { }
 	}
 }
@@ -36,6 +36,8 @@ namespace DSO.AST.Nodes
 			^ Class.GetHashCode() ^ (Name?.GetHashCode() ?? 0) ^ (Parent?.GetHashCode() ?? 0)
 			^ Depth.GetHashCode() ^ _arguments.GetHashCode() ^ Fields.GetHashCode() ^ Children.GetHashCode();
 
+		public override int NodeCount => 1 + Class.NodeCount + (Name?.NodeCount ?? 0) + CountNodes(_arguments) + CountNodes(Fields) + CountNodes(Children);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(IsDataBlock ? "datablock" : "new", " ");
@@ -19,6 +19,8 @@ namespace DSO.AST.Nodes
 		public override bool Equals(object? obj) => base.Equals(obj) && obj is ReturnNode node && Equals(node.Value, Value);
 		public override int GetHashCode() => base.GetHashCode() ^ (Value?.GetHashCode() ?? 0);
 
+		public override int NodeCount => 1 + (Value?.NodeCount ?? 0);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write("return");
@@ -23,6 +23,8 @@ namespace DSO.AST.Nodes
 		public override bool Equals(object? obj) => base.Equals(obj) && obj is UnaryNode node && node.Node.Equals(Node) && node.Op.Equals(Op);
 		public override int GetHashCode() => base.GetHashCode() ^ Node.GetHashCode() ^ Op.GetHashCode();
 
+		public override int NodeCount => 1 + Node.NodeCount;
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(Op.Tag switch
@@ -22,6 +22,8 @@ namespace DSO.AST.Nodes
 
 		public override int GetHashCode() => base.GetHashCode() ^ Unit.GetHashCode() ^ Value.GetHashCode();
 
+		public override int NodeCount => 1 + Unit.NodeCount + Value.NodeCount;
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(Value, isExpression: true);
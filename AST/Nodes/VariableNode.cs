@@ -20,6 +20,8 @@ namespace DSO.AST.Nodes
 		public override bool Equals(object? obj) => base.Equals(obj) && obj is VariableNode node && node.Name.Equals(Name) && Equals(node.Index, Index);
 		public override int GetHashCode() => base.GetHashCode() ^ Name.GetHashCode() ^ (Index?.GetHashCode() ?? 0);
 
+		public override int NodeCount => 1 + (Index?.NodeCount ?? 0);
+
 		public override void Visit(CodeWriter writer, bool isExpression)
 		{
 			writer.Write(Name);
@@ -0,0 +1,107 @@
+﻿/**
+ * ParallelBuilder.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.AST.Nodes;
+using DSO.ControlFlow;
+using DSO.Disassembler;
+using DSO.Opcodes;
+using System.Runtime.ExceptionServices;
+
+namespace DSO.AST
+{
+	/// <summary>
+	/// Builds the bodies of every function in a file on multiple threads at once, then builds the rest of the file
+	/// around them like normal.<br/><br/>
+	///
+	/// Function bodies never jump outside of themselves, so each one gets its own slice of the control flow data
+	/// and its own <see cref="Builder"/>. Everything outside of the bodies (including grouping functions into
+	/// packages) is still done on one thread and in address order, so the output is the same either way.
+	/// </summary>
+	public class ParallelBuilder(int jobs, BuilderPool builders)
+	{
+		/// <summary>
+		/// Not worth splitting files with fewer functions than this.
+		/// </summary>
+		private const int MIN_FUNCTIONS = 2;
+
+		private readonly int _jobs = jobs;
+		private readonly BuilderPool _builders = builders;
+
+		public List<Node> Build(ControlFlowData data, Disassembly disassembly, NodeListArena? arena = null)
+		{
+			var functions = FindFunctions(disassembly);
+
+			if (functions.Count < MIN_FUNCTIONS || _jobs <= 1)
+			{
+				return _builders.Use(builder => builder.Build(data, disassembly, arena: arena));
+			}
+
+			var ranges = functions.Select(function => (function.Address, function.EndAddress)).ToList();
+			var slices = data.Split(ranges);
+			var bodies = new List<Node>[functions.Count];
+			var exceptions = new Exception?[functions.Count];
+
+			Parallel.For(0, functions.Count, new ParallelOptions { MaxDegreeOfParallelism = _jobs }, index =>
+			{
+				var function = functions[index];
+
+				try
+				{
+					bodies[index] = _builders.Use(builder => builder.Build(slices[index], disassembly, function.Next!.Address, function.EndAddress - 1, arena: arena));
+				}
+				catch (Exception exception)
+				{
+					exceptions[index] = exception;
+				}
+			});
+
+			// Report the same error we would have gotten building the file on one thread.
+			if (exceptions.FirstOrDefault(exception => exception != null) is Exception first)
+			{
+				ExceptionDispatchInfo.Throw(first);
+			}
+
+			var built = new Dictionary<uint, List<Node>>(functions.Count);
+
+			for (var i = 0; i < functions.Count; i++)
+			{
+				built[functions[i].Address] = bodies[i];
+			}
+
+			return _builders.Use(builder => builder.Build(data, disassembly, built, arena));
+		}
+
+		/// <summary>
+		/// Finds every function with a body, in address order.
+		/// </summary>
+		static private List<FunctionInstruction> FindFunctions(Disassembly disassembly)
+		{
+			var functions = new List<FunctionInstruction>();
+			var stream = disassembly.Stream;
+			uint end = 0;
+
+			for (var index = 0; index < stream.Count; index++)
+			{
+				if (stream.GetTag(index) != OpcodeTag.OP_FUNC_DECL || stream.GetAddress(index) < end)
+				{
+					continue;
+				}
+
+				if (disassembly[index] is FunctionInstruction function && function.HasBody && function.Next != null && function.EndAddress > function.Next.Address)
+				{
+					functions.Add(function);
+					end = function.EndAddress;
+				}
+			}
+
+			return functions;
+		}
+	}
+}
@@ -0,0 +1,266 @@
+﻿/**
+ * BenchmarkRunner.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.AST;
+using DSO.ControlFlow;
+using DSO.Disassembler;
+using DSO.Util;
+using DSO.Versions;
+using System.Diagnostics;
+
+using static DSO.Constants.Decompiler;
+
+namespace DSO.Benchmark
+{
+	/// <summary>
+	/// Times each stage of the decompiler separately on generated files, so that throughput and allocation
+	/// regressions show up before they reach anyone.<br/><br/>
+	///
+	/// Each iteration runs the whole pipeline from scratch, since later stages depend on the output of earlier
+	/// ones, but only the time and memory of each stage itself is counted towards it.
+	/// </summary>
+	public class BenchmarkRunner
+	{
+		private class StageResult
+		{
+			public long TotalTicks = 0;
+			public long MinTicks = long.MaxValue;
+			public long AllocatedBytes = 0;
+		}
+
+		static private readonly FileGeneratorSettings[] _presets =
+		[
+			new() { Name = "small", Functions = 4, NestingDepth = 1, Strings = 16 },
+			new() { Name = "large", Functions = 256, NestingDepth = 2, Strings = 256 },
+			new() { Name = "nested", Functions = 16, NestingDepth = 12, Strings = 16 },
+			new() { Name = "strings", Functions = 16, NestingDepth = 2, Strings = 8192 },
+			new() { Name = "ladder", Functions = 4, NestingDepth = 1, Strings = 16, Branches = 512 },
+		];
+
+		private const int WARMUP_ITERATIONS = 3;
+		private const int MIN_ITERATIONS = 10;
+		private const int MAX_ITERATIONS = 1000;
+		private const long TIME_BUDGET_MS = 250;
+		private const int STARTUP_ITERATIONS = 10;
+
+		static private readonly Stage[] _stages = [Stage.Load, Stage.Disassemble, Stage.ControlFlow, Stage.Build, Stage.Generate];
+
+		/// <summary>
+		/// Both reused between iterations, same as they are between files when decompiling.
+		/// </summary>
+		private readonly Builder _builder = new();
+		private readonly NodeListArena _arena = new();
+
+		/// <summary>
+		/// Benchmarks every game, or just the one in <see cref="CommandLineOptions.GameIdentifier"/> if there is one.
+		/// Files are generated with <see cref="CommandLineOptions.BenchmarkSettings"/> if there are any, and with each
+		/// of the presets otherwise.
+		/// </summary>
+		public bool Run(CommandLineOptions options)
+		{
+			var identifiers = options.GameIdentifier == GameIdentifier.Auto
+				? GameVersion.Games
+				: [options.GameIdentifier];
+
+			FileGeneratorSettings[] presets = options.BenchmarkSettings != null ? [options.BenchmarkSettings] : _presets;
+
+			foreach (var identifier in identifiers)
+			{
+				foreach (var preset in presets)
+				{
+					if (!Run(identifier, preset))
+					{
+						return false;
+					}
+				}
+			}
+
+			return RunStartup(identifiers[0]);
+		}
+
+		/// <summary>
+		/// Times how long it takes to run this program on a single small file, from starting the process to it
+		/// exiting. That's mostly startup time, which is what matters when a build script runs it once per file.
+		/// </summary>
+		private bool RunStartup(GameIdentifier identifier)
+		{
+			var directory = Directory.CreateTempSubdirectory("dso-sharp-");
+			var result = new StageResult();
+
+			try
+			{
+				var path = Path.Join(directory.FullName, $"startup{EXTENSION}");
+
+				File.WriteAllBytes(path, FileGenerator.Generate(identifier, _presets[0]));
+
+				var startInfo = CreateStartInfo();
+
+				startInfo.ArgumentList.Add(path);
+				startInfo.ArgumentList.Add("-X");
+				startInfo.ArgumentList.Add("-q");
+
+				for (var i = 0; i < STARTUP_ITERATIONS; i++)
+				{
+					var start = Stopwatch.GetTimestamp();
+
+					using var process = Process.Start(startInfo) ?? throw new IOException("Process could not be started");
+
+					process.StandardOutput.ReadToEnd();
+					process.WaitForExit();
+
+					var ticks = Stopwatch.GetTimestamp() - start;
+
+					if (process.ExitCode != 0)
+					{
+						throw new IOException($"Process exited with code {process.ExitCode}");
+					}
+
+					result.TotalTicks += ticks;
+					result.MinTicks = Math.Min(result.MinTicks, ticks);
+				}
+			}
+			catch (Exception exception)
+			{
+				Logger.LogError($"Failed to benchmark startup: {exception.Message}");
+
+				return false;
+			}
+			finally
+			{
+				directory.Delete(recursive: true);
+			}
+
+			Logger.LogMessage($"Startup ({GameVersion.GetDisplayName(identifier)}, {_presets[0].Name}, {STARTUP_ITERATIONS} runs)");
+			Logger.LogMessage("    {0,-12}{1,14}{2,14}", "stage", "mean", "min");
+			Logger.LogMessage("    {0,-12}{1,14}{2,14}", "process", FormatTime(result.TotalTicks / (double) STARTUP_ITERATIONS), FormatTime(result.MinTicks));
+			Logger.LogMessage("");
+
+			return true;
+		}
+
+		/// <summary>
+		/// Runs the same program we're running in, whether that's a native executable or a DLL run with `dotnet`.
+		/// </summary>
+		static private ProcessStartInfo CreateStartInfo()
+		{
+			var processPath = Environment.ProcessPath ?? throw new IOException("Could not find the path of this program");
+			var startInfo = new ProcessStartInfo(processPath)
+			{
+				UseShellExecute = false,
+				RedirectStandardOutput = true,
+			};
+
+			if (Path.GetFileNameWithoutExtension(processPath) == "dotnet")
+			{
+				startInfo.ArgumentList.Add(Environment.GetCommandLineArgs()[0]);
+			}
+
+			return startInfo;
+		}
+
+		private bool Run(GameIdentifier identifier, FileGeneratorSettings settings)
+		{
+			var bytes = FileGenerator.Generate(identifier, settings);
+			var results = new StageResult[Enum.GetValues<Stage>().Length];
+
+			for (var i = 0; i < results.Length; i++)
+			{
+				results[i] = new();
+			}
+
+			try
+			{
+				for (var i = 0; i < WARMUP_ITERATIONS; i++)
+				{
+					RunIteration(identifier, bytes, null);
+				}
+			}
+			catch (Exception exception)
+			{
+				Logger.LogError($"Failed to decompile generated file ({GameVersion.GetDisplayName(identifier)}, {settings.Name}): {exception.Message}");
+
+				return false;
+			}
+
+			var iterations = 0;
+			var stopwatch = Stopwatch.StartNew();
+
+			while (iterations < MAX_ITERATIONS && (iterations < MIN_ITERATIONS || stopwatch.ElapsedMilliseconds < TIME_BUDGET_MS))
+			{
+				RunIteration(identifier, bytes, results);
+				iterations++;
+			}
+
+			Logger.LogMessage($"{GameVersion.GetDisplayName(identifier)} / {settings.Name} ({bytes.Length:N0} bytes, {iterations} iterations)");
+			Logger.LogMessage("    {0,-12}{1,14}{2,14}{3,16}", "stage", "mean", "min", "allocated");
+
+			foreach (var stage in _stages)
+			{
+				var result = results[(int) stage];
+
+				Logger.LogMessage("    {0,-12}{1,14}{2,14}{3,16}",
+					stage.ToString().ToLower(),
+					FormatTime(result.TotalTicks / (double) iterations),
+					FormatTime(result.MinTicks),
+					FormatBytes(result.AllocatedBytes / (double) iterations));
+			}
+
+			Logger.LogMessage("");
+
+			return true;
+		}
+
+		private void RunIteration(GameIdentifier identifier, byte[] bytes, StageResult[]? results)
+		{
+			var game = GameVersion.Create(identifier)!;
+
+			var data = Measure(Stage.Load, results, () => game.FileLoader!.LoadFile(bytes));
+			var disassembly = Measure(Stage.Disassemble, results, () => new Disassembler.Disassembler().Disassemble(GameVersion.CreateBytecodeReader(identifier, data, game.Ops!)!));
+			var controlFlow = Measure(Stage.ControlFlow, results, () => new ControlFlowAnalyzer().Analyze(disassembly));
+			var nodes = Measure(Stage.Build, results, () => _builder.Build(controlFlow, disassembly, arena: _arena));
+
+			Measure(Stage.Generate, results, () =>
+			{
+				new CodeGenerator.CodeGenerator().Generate(nodes, TextWriter.Null);
+				return nodes;
+			});
+
+			_arena.Reset();
+		}
+
+		static private T Measure<T>(Stage stage, StageResult[]? results, Func<T> run)
+		{
+			var measurement = new StageMeasurement();
+			var value = measurement.Measure(run);
+
+			if (results != null)
+			{
+				var result = results[(int) stage];
+
+				result.TotalTicks += measurement.Ticks;
+				result.MinTicks = Math.Min(result.MinTicks, measurement.Ticks);
+				result.AllocatedBytes += measurement.AllocatedBytes;
+			}
+
+			return value;
+		}
+
+		static private string FormatTime(double ticks)
+		{
+			var microseconds = ticks * 1_000_000.0 / Stopwatch.Frequency;
+
+			return microseconds >= 1000.0 ? $"{microseconds / 1000.0:F2} ms" : $"{microseconds:F1} us";
+		}
+
+		static private string FormatBytes(double bytes) => bytes >= 1024.0 * 1024.0
+			? $"{bytes / (1024.0 * 1024.0):F2} MB"
+			: $"{bytes / 1024.0:F1} KB";
+	}
+}
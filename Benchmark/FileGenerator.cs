@@ -0,0 +1,717 @@
+﻿/**
+ * FileGenerator.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.Opcodes;
+using DSO.Versions;
+using System.Buffers.Binary;
+using System.Text;
+
+namespace DSO.Benchmark
+{
+	public class FileGeneratorSettings
+	{
+		public string Name { get; set; } = "";
+
+		/// <summary>
+		/// How many functions to declare. Each one also gets an object and a call to it at the top level.
+		/// </summary>
+		public int Functions { get; set; } = 16;
+
+		/// <summary>
+		/// How many if/while statements deep the body of each function goes.
+		/// </summary>
+		public int NestingDepth { get; set; } = 2;
+
+		/// <summary>
+		/// How many extra string literals to assign to global variables, on top of the ones the functions use.
+		/// </summary>
+		public int Strings { get; set; } = 64;
+
+		/// <summary>
+		/// How many arms the else-if chain and the chained ternary in the extra `dispatch` function get, or 0 to
+		/// leave it out.
+		/// </summary>
+		public int Branches { get; set; } = 0;
+	}
+
+	/// <summary>
+	/// Assembles synthetic DSO files that exercise the whole pipeline (functions, packages, namespaces, objects,
+	/// loops, if/else chains, ternaries, logical operators, and string concatenation).<br/><br/>
+	///
+	/// Opcode values come straight from each game's <see cref="Ops"/>, so every game we support can be generated.
+	/// </summary>
+	public class FileGenerator
+	{
+		private class Label
+		{
+			public uint Address = 0;
+		}
+
+		private class TableBuilder
+		{
+			public readonly List<byte> Strings = [];
+			public readonly Dictionary<string, uint> StringIndices = [];
+			public readonly List<double> Floats = [];
+
+			public uint AddString(string value)
+			{
+				if (!StringIndices.TryGetValue(value, out uint index))
+				{
+					index = (uint) Strings.Count;
+
+					StringIndices[value] = index;
+					Strings.AddRange(Encoding.Latin1.GetBytes(value));
+					Strings.Add(0);
+				}
+
+				return index;
+			}
+
+			public uint AddFloat(double value)
+			{
+				var index = Floats.IndexOf(value);
+
+				if (index < 0)
+				{
+					index = Floats.Count;
+					Floats.Add(value);
+				}
+
+				return (uint) index;
+			}
+		}
+
+		static private readonly byte[] _blocklandKey = "cl3buotro"u8.ToArray();
+
+		private readonly GameIdentifier _identifier;
+		private readonly Dictionary<OpcodeTag, uint> _ops = [];
+		private readonly List<uint> _code = [];
+		private readonly List<Tuple<int, Label>> _fixups = [];
+		private readonly Dictionary<uint, List<uint>> _identifiers = [];
+		private readonly TableBuilder _global = new();
+		private readonly TableBuilder _function = new();
+		private bool _inFunction = false;
+
+		/// <exception cref="ArgumentException">
+		/// Throws if <paramref name="identifier"/> isn't an actual game.
+		/// </exception>
+		public FileGenerator(GameIdentifier identifier)
+		{
+			var ops = GameVersion.GetOps(identifier) ?? throw new ArgumentException($"Invalid game identifier: {identifier}");
+
+			_identifier = identifier;
+
+			for (uint value = 0; value < 0x100; value++)
+			{
+				if (ops.IsValid(value))
+				{
+					_ops[ops.GetOpcodeTag(value)] = value;
+				}
+			}
+		}
+
+		static public byte[] Generate(GameIdentifier identifier, FileGeneratorSettings settings) => new FileGenerator(identifier).Generate(settings);
+
+		public byte[] Generate(FileGeneratorSettings settings)
+		{
+			for (var i = 0; i < settings.Functions; i++)
+			{
+				WriteFunction(i, settings.NestingDepth);
+				WriteObject(i);
+
+				// $result = foo0("1", "2.5");
+				WriteCall($"foo{i}", namespaceName: i % 2 == 1 ? "Bar" : null, () => WriteString("1"), () => WriteString("2.5"));
+				WriteAssignment($"$result", OpcodeTag.OP_SAVEVAR_STR, OpcodeTag.OP_STR_TO_NONE);
+			}
+
+			WriteLoopsFunction();
+
+			if (settings.Branches > 0)
+			{
+				WriteDispatchFunction(settings.Branches);
+			}
+
+			for (var i = 0; i < settings.Strings; i++)
+			{
+				WriteString($"string {i}: \"quoted\"\t{new string((char) ('a' + i % 26), i % 32)}");
+				WriteAssignment($"$string{i}", OpcodeTag.OP_SAVEVAR_STR, OpcodeTag.OP_STR_TO_NONE);
+			}
+
+			WriteOp(OpcodeTag.OP_RETURN);
+
+			return Build();
+		}
+
+		private void WriteFunction(int index, int depth)
+		{
+			var end = new Label();
+
+			WriteOp(OpcodeTag.OP_FUNC_DECL);
+			WriteIdentifier($"foo{index}");
+			WriteIdentifier(index % 2 == 1 ? "Bar" : null);
+			WriteIdentifier(index % 3 == 2 ? $"Package{index / 3}" : null);
+			Write(1);
+			WriteLabel(end);
+			Write(2);
+			WriteIdentifier("%a");
+			WriteIdentifier("%b");
+
+			_inFunction = true;
+
+			// %i = 0;
+			WriteOp(OpcodeTag.OP_LOADIMMED_UINT);
+			Write(0);
+			WriteAssignment("%i", OpcodeTag.OP_SAVEVAR_UINT, OpcodeTag.OP_UINT_TO_NONE);
+
+			WriteNestedBody(depth);
+
+			// %c = %a ? "x" : "y";
+			var ternaryFalse = new Label();
+			var ternaryEnd = new Label();
+
+			WriteVariable("%a", OpcodeTag.OP_LOADVAR_UINT);
+			WriteBranch(OpcodeTag.OP_JMPIFNOT, ternaryFalse);
+			WriteString("x");
+			WriteBranch(OpcodeTag.OP_JMP, ternaryEnd);
+			Mark(ternaryFalse);
+			WriteString("y");
+			Mark(ternaryEnd);
+			WriteAssignment("%c", OpcodeTag.OP_SAVEVAR_STR, OpcodeTag.OP_STR_TO_NONE);
+
+			// %d = %a && %b;
+			var and = new Label();
+
+			WriteVariable("%a", OpcodeTag.OP_LOADVAR_UINT);
+			WriteBranch(OpcodeTag.OP_JMPIFNOT_NP, and);
+			WriteVariable("%b", OpcodeTag.OP_LOADVAR_UINT);
+			Mark(and);
+			WriteAssignment("%d", OpcodeTag.OP_SAVEVAR_UINT, OpcodeTag.OP_UINT_TO_NONE);
+
+			// return %a SPC %b @ "z";
+			WriteVariable("%a", OpcodeTag.OP_LOADVAR_STR);
+			WriteOp(OpcodeTag.OP_ADVANCE_STR_APPENDCHAR);
+			Write(' ');
+			WriteVariable("%b", OpcodeTag.OP_LOADVAR_STR);
+			WriteOp(OpcodeTag.OP_REWIND_STR);
+			WriteOp(OpcodeTag.OP_ADVANCE_STR);
+			WriteString("z");
+			WriteOp(OpcodeTag.OP_REWIND_STR);
+			WriteOp(OpcodeTag.OP_RETURN);
+			WriteOp(OpcodeTag.OP_RETURN);
+
+			_inFunction = false;
+
+			Mark(end);
+		}
+
+		/// <summary>
+		/// <code>
+		/// function dispatch(%a)
+		/// {
+		///     %r = %a == 0 ? "0" : %a == 1 ? "1" : ... : "none";
+		///
+		///     if (%a == 0)
+		///     {
+		///         echo("0");
+		///     }
+		///     else if (%a == 1)
+		///     ...
+		///     else
+		///     {
+		///         echo("none");
+		///     }
+		/// }
+		/// </code>
+		/// </summary>
+		private void WriteDispatchFunction(int branches)
+		{
+			var end = new Label();
+
+			WriteOp(OpcodeTag.OP_FUNC_DECL);
+			WriteIdentifier("dispatch");
+			WriteIdentifier(null);
+			WriteIdentifier(null);
+			Write(1);
+			WriteLabel(end);
+			Write(1);
+			WriteIdentifier("%a");
+
+			_inFunction = true;
+
+			var ternaryEnd = new Label();
+
+			for (var i = 0; i < branches; i++)
+			{
+				var next = new Label();
+
+				WriteFloat(i);
+				WriteVariable("%a", OpcodeTag.OP_LOADVAR_FLT);
+				WriteOp(OpcodeTag.OP_CMPEQ);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, next);
+				WriteString($"{i}");
+				WriteBranch(OpcodeTag.OP_JMP, ternaryEnd);
+				Mark(next);
+			}
+
+			WriteString("none");
+			Mark(ternaryEnd);
+			WriteAssignment("%r", OpcodeTag.OP_SAVEVAR_STR, OpcodeTag.OP_STR_TO_NONE);
+
+			var ifEnd = new Label();
+
+			for (var i = 0; i < branches; i++)
+			{
+				var next = new Label();
+
+				WriteFloat(i);
+				WriteVariable("%a", OpcodeTag.OP_LOADVAR_FLT);
+				WriteOp(OpcodeTag.OP_CMPEQ);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, next);
+				WriteCall("echo", null, () => WriteString($"{i}"));
+				WriteOp(OpcodeTag.OP_STR_TO_NONE);
+				WriteBranch(OpcodeTag.OP_JMP, ifEnd);
+				Mark(next);
+			}
+
+			WriteCall("echo", null, () => WriteString("none"));
+			WriteOp(OpcodeTag.OP_STR_TO_NONE);
+			Mark(ifEnd);
+			WriteOp(OpcodeTag.OP_RETURN);
+
+			_inFunction = false;
+
+			Mark(end);
+		}
+
+		/// <summary>
+		/// If statements in loops whose else leaves the loop or the function, so there's nowhere for both sides to
+		/// meet up again. These are easy to get wrong when working out which jumps are elses and which are continues.
+		/// The last loop comes after a return, so it can't be reached at all.
+		/// <code>
+		/// function loops(%a, %b, %c)
+		/// {
+		///     while (%a) { if (%b) { %x = 1; } else { continue; } %y = 1; }
+		///     while (%a) { if (%b) { %x = 1; } else if (%c) { break; } %y = 1; }
+		///     while (%a) { if (%b) { %x = 1; } else { return; } %y = 1; }
+		///     while (%a) { if (%b) { continue; } %x = 1; }
+		///     return;
+		///     while (%a) { if (%a) { %x = 1; } }
+		/// }
+		/// </code>
+		/// </summary>
+		private void WriteLoopsFunction()
+		{
+			var end = new Label();
+
+			WriteOp(OpcodeTag.OP_FUNC_DECL);
+			WriteIdentifier("loops");
+			WriteIdentifier(null);
+			WriteIdentifier(null);
+			Write(1);
+			WriteLabel(end);
+			Write(3);
+			WriteIdentifier("%a");
+			WriteIdentifier("%b");
+			WriteIdentifier("%c");
+
+			_inFunction = true;
+
+			WriteLoop((continuePoint, breakPoint) =>
+			{
+				var elseLabel = new Label();
+				var endIf = new Label();
+
+				WriteVariable("%b", OpcodeTag.OP_LOADVAR_UINT);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, elseLabel);
+				WriteUIntAssignment("%x", 1);
+				WriteBranch(OpcodeTag.OP_JMP, endIf);
+				Mark(elseLabel);
+				WriteBranch(OpcodeTag.OP_JMP, continuePoint);
+				Mark(endIf);
+				WriteUIntAssignment("%y", 1);
+			});
+
+			WriteLoop((continuePoint, breakPoint) =>
+			{
+				var elseLabel = new Label();
+				var endIf = new Label();
+
+				WriteVariable("%b", OpcodeTag.OP_LOADVAR_UINT);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, elseLabel);
+				WriteUIntAssignment("%x", 1);
+				WriteBranch(OpcodeTag.OP_JMP, endIf);
+				Mark(elseLabel);
+				WriteVariable("%c", OpcodeTag.OP_LOADVAR_UINT);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, endIf);
+				WriteBranch(OpcodeTag.OP_JMP, breakPoint);
+				Mark(endIf);
+				WriteUIntAssignment("%y", 1);
+			});
+
+			WriteLoop((continuePoint, breakPoint) =>
+			{
+				var elseLabel = new Label();
+				var endIf = new Label();
+
+				WriteVariable("%b", OpcodeTag.OP_LOADVAR_UINT);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, elseLabel);
+				WriteUIntAssignment("%x", 1);
+				WriteBranch(OpcodeTag.OP_JMP, endIf);
+				Mark(elseLabel);
+				WriteOp(OpcodeTag.OP_RETURN);
+				Mark(endIf);
+				WriteUIntAssignment("%y", 1);
+			});
+
+			WriteLoop((continuePoint, breakPoint) =>
+			{
+				var endIf = new Label();
+
+				WriteVariable("%b", OpcodeTag.OP_LOADVAR_UINT);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, endIf);
+				WriteBranch(OpcodeTag.OP_JMP, continuePoint);
+				Mark(endIf);
+				WriteUIntAssignment("%x", 1);
+			});
+
+			WriteOp(OpcodeTag.OP_RETURN);
+
+			WriteLoop((continuePoint, breakPoint) =>
+			{
+				var endIf = new Label();
+
+				WriteVariable("%a", OpcodeTag.OP_LOADVAR_UINT);
+				WriteBranch(OpcodeTag.OP_JMPIFNOT, endIf);
+				WriteUIntAssignment("%x", 1);
+				Mark(endIf);
+			});
+
+			WriteOp(OpcodeTag.OP_RETURN);
+
+			_inFunction = false;
+
+			Mark(end);
+		}
+
+		/// <summary>
+		/// <code>while (%a) { &lt;body&gt; }</code>
+		///
+		/// The body gets the labels that a continue and a break jump to.
+		/// </summary>
+		private void WriteLoop(Action<Label, Label> writeBody)
+		{
+			var loopStart = new Label();
+			var continuePoint = new Label();
+			var breakPoint = new Label();
+
+			WriteVariable("%a", OpcodeTag.OP_LOADVAR_UINT);
+			WriteBranch(OpcodeTag.OP_JMPIFNOT, breakPoint);
+			Mark(loopStart);
+
+			writeBody(continuePoint, breakPoint);
+
+			Mark(continuePoint);
+			WriteVariable("%a", OpcodeTag.OP_LOADVAR_UINT);
+			WriteBranch(OpcodeTag.OP_JMPIF, loopStart);
+			Mark(breakPoint);
+		}
+
+		/// <summary>
+		/// <code>
+		/// if (%a == depth)
+		/// {
+		///     while (%i &lt; 10)
+		///     {
+		///         &lt;nested body of depth - 1&gt;
+		///         %i = %i + 1;
+		///     }
+		/// }
+		/// else
+		/// {
+		///     echo("other");
+		/// }
+		/// </code>
+		/// </summary>
+		private void WriteNestedBody(int depth)
+		{
+			if (depth <= 0)
+			{
+				WriteCall("echo", null, () => WriteString($"leaf \"{_code.Count}\"\n"));
+				WriteOp(OpcodeTag.OP_STR_TO_NONE);
+
+				return;
+			}
+
+			var elseLabel = new Label();
+			var endIf = new Label();
+			var loopStart = new Label();
+			var loopEnd = new Label();
+
+			WriteFloat(depth);
+			WriteVariable("%a", OpcodeTag.OP_LOADVAR_FLT);
+			WriteOp(OpcodeTag.OP_CMPEQ);
+			WriteBranch(OpcodeTag.OP_JMPIFNOT, elseLabel);
+
+			WriteLoopTest();
+			WriteBranch(OpcodeTag.OP_JMPIFNOT, loopEnd);
+			Mark(loopStart);
+
+			WriteNestedBody(depth - 1);
+
+			WriteFloat(1.0);
+			WriteVariable("%i", OpcodeTag.OP_LOADVAR_FLT);
+			WriteOp(OpcodeTag.OP_ADD);
+			WriteAssignment("%i", OpcodeTag.OP_SAVEVAR_FLT, OpcodeTag.OP_FLT_TO_NONE);
+
+			WriteLoopTest();
+			WriteBranch(OpcodeTag.OP_JMPIF, loopStart);
+			Mark(loopEnd);
+
+			WriteBranch(OpcodeTag.OP_JMP, endIf);
+			Mark(elseLabel);
+			WriteCall("echo", null, () => WriteString("other"));
+			WriteOp(OpcodeTag.OP_STR_TO_NONE);
+			Mark(endIf);
+		}
+
+		private void WriteLoopTest()
+		{
+			WriteFloat(10.0);
+			WriteVariable("%i", OpcodeTag.OP_LOADVAR_FLT);
+			WriteOp(OpcodeTag.OP_CMPLT);
+		}
+
+		/// <summary>
+		/// <code>new ScriptObject("Object0") { field = "value0"; };</code>
+		/// </summary>
+		private void WriteObject(int index)
+		{
+			var fail = new Label();
+
+			WriteOp(OpcodeTag.OP_LOADIMMED_UINT);
+			Write(0);
+			WriteOp(OpcodeTag.OP_PUSH_FRAME);
+			WriteOp(OpcodeTag.OP_LOADIMMED_IDENT);
+			WriteIdentifier("ScriptObject");
+			WriteOp(OpcodeTag.OP_PUSH);
+			WriteString($"Object{index}");
+			WriteOp(OpcodeTag.OP_PUSH);
+			WriteOp(OpcodeTag.OP_CREATE_OBJECT);
+			WriteIdentifier(null);
+			Write(0);
+
+			if (_identifier == GameIdentifier.TCON)
+			{
+				Write(0);
+			}
+
+			WriteLabel(fail);
+
+			WriteString($"value{index}");
+			WriteOp(OpcodeTag.OP_SETCUROBJECT_NEW);
+			WriteOp(OpcodeTag.OP_SETCURFIELD);
+			WriteIdentifier("field");
+			WriteOp(OpcodeTag.OP_SAVEFIELD_STR);
+			WriteOp(OpcodeTag.OP_STR_TO_NONE);
+
+			WriteOp(OpcodeTag.OP_ADD_OBJECT);
+			Write(1);
+			WriteOp(OpcodeTag.OP_END_OBJECT);
+			Write(1);
+
+			Mark(fail);
+			WriteOp(OpcodeTag.OP_UINT_TO_NONE);
+		}
+
+		private void WriteCall(string name, string? namespaceName, params Action[] arguments)
+		{
+			WriteOp(OpcodeTag.OP_PUSH_FRAME);
+
+			foreach (var argument in arguments)
+			{
+				argument();
+				WriteOp(OpcodeTag.OP_PUSH);
+			}
+
+			WriteOp(OpcodeTag.OP_CALLFUNC);
+			WriteIdentifier(name);
+			WriteIdentifier(namespaceName);
+			Write(0);
+		}
+
+		private void WriteVariable(string name, OpcodeTag load)
+		{
+			WriteOp(OpcodeTag.OP_SETCURVAR);
+			WriteIdentifier(name);
+			WriteOp(load);
+		}
+
+		private void WriteAssignment(string name, OpcodeTag save, OpcodeTag convert)
+		{
+			WriteOp(OpcodeTag.OP_SETCURVAR_CREATE);
+			WriteIdentifier(name);
+			WriteOp(save);
+			WriteOp(convert);
+		}
+
+		private void WriteUIntAssignment(string name, uint value)
+		{
+			WriteOp(OpcodeTag.OP_LOADIMMED_UINT);
+			Write(value);
+			WriteAssignment(name, OpcodeTag.OP_SAVEVAR_UINT, OpcodeTag.OP_UINT_TO_NONE);
+		}
+
+		private void WriteString(string value)
+		{
+			WriteOp(OpcodeTag.OP_LOADIMMED_STR);
+			Write((_inFunction ? _function : _global).AddString(value));
+		}
+
+		private void WriteFloat(double value)
+		{
+			WriteOp(OpcodeTag.OP_LOADIMMED_FLT);
+			Write((_inFunction ? _function : _global).AddFloat(value));
+		}
+
+		/// <summary>
+		/// Identifiers always go in the global string table, and are patched into the code by the identifier table.
+		/// </summary>
+		private void WriteIdentifier(string? name)
+		{
+			if (name == null)
+			{
+				Write(0);
+				return;
+			}
+
+			var index = _global.AddString(name);
+
+			if (!_identifiers.TryGetValue(index, out List<uint>? addresses))
+			{
+				addresses = [];
+				_identifiers[index] = addresses;
+			}
+
+			addresses.Add((uint) _code.Count);
+
+			Write(0);
+		}
+
+		private void WriteBranch(OpcodeTag tag, Label target)
+		{
+			WriteOp(tag);
+			WriteLabel(target);
+		}
+
+		private void WriteLabel(Label label)
+		{
+			_fixups.Add(new(_code.Count, label));
+
+			Write(0);
+		}
+
+		private void Mark(Label label) => label.Address = (uint) _code.Count;
+
+		private void WriteOp(OpcodeTag tag) => _code.Add(_ops[tag]);
+		private void Write(uint value) => _code.Add(value);
+
+		private byte[] Build()
+		{
+			foreach (var (address, label) in _fixups)
+			{
+				_code[address] = label.Address;
+			}
+
+			var output = new List<byte>();
+
+			WriteUInt(output, GameVersion.GetVersionFromIdentifier(_identifier));
+
+			// TGE 1.4 and Constructor put both string tables before the float tables.
+			if (_identifier == GameIdentifier.TGE14 || _identifier == GameIdentifier.TCON)
+			{
+				WriteStringTable(output, _global);
+				WriteStringTable(output, _function);
+				WriteFloatTable(output, _global);
+				WriteFloatTable(output, _function);
+			}
+			else
+			{
+				WriteStringTable(output, _global);
+				WriteFloatTable(output, _global);
+				WriteStringTable(output, _function);
+				WriteFloatTable(output, _function);
+			}
+
+			WriteUInt(output, (uint) _code.Count);
+			WriteUInt(output, 0);
+
+			foreach (var value in _code)
+			{
+				if (value < 0xFF)
+				{
+					output.Add((byte) value);
+				}
+				else
+				{
+					output.Add(0xFF);
+					WriteUInt(output, value);
+				}
+			}
+
+			WriteUInt(output, (uint) _identifiers.Count);
+
+			foreach (var (index, addresses) in _identifiers)
+			{
+				WriteUInt(output, index);
+				WriteUInt(output, (uint) addresses.Count);
+
+				foreach (var address in addresses)
+				{
+					WriteUInt(output, address);
+				}
+			}
+
+			return [.. output];
+		}
+
+		private void WriteStringTable(List<byte> output, TableBuilder table)
+		{
+			var encrypt = _identifier == GameIdentifier.BlocklandV20 || _identifier == GameIdentifier.BlocklandV21;
+
+			WriteUInt(output, (uint) table.Strings.Count);
+
+			for (var i = 0; i < table.Strings.Count; i++)
+			{
+				output.Add(encrypt ? (byte) (table.Strings[i] ^ _blocklandKey[i % _blocklandKey.Length]) : table.Strings[i]);
+			}
+		}
+
+		static private void WriteFloatTable(List<byte> output, TableBuilder table)
+		{
+			WriteUInt(output, (uint) table.Floats.Count);
+
+			Span<byte> bytes = stackalloc byte[sizeof(double)];
+
+			foreach (var value in table.Floats)
+			{
+				BinaryPrimitives.WriteDoubleLittleEndian(bytes, value);
+				output.AddRange(bytes);
+			}
+		}
+
+		static private void WriteUInt(List<byte> output, uint value)
+		{
+			Span<byte> bytes = stackalloc byte[sizeof(uint)];
+
+			BinaryPrimitives.WriteUInt32LittleEndian(bytes, value);
+			output.AddRange(bytes);
+		}
+	}
+}
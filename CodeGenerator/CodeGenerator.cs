@@ -21,18 +21,28 @@ namespace DSO.CodeGenerator
 
 	public class CodeGenerator
 	{
-		private CodeWriter _writer = new();
+		private CodeWriter _writer = new(TextWriter.Null);
 
-		public List<string> Generate(List<Node> nodes)
+		public string Generate(List<Node> nodes)
 		{
-			_writer = new();
+			var output = new StringWriter();
+
+			Generate(nodes, output);
+
+			return output.ToString();
+		}
+
+		/// <summary>
+		/// Generates code directly into <paramref name="output"/> rather than building it up in memory first.
+		/// </summary>
+		public void Generate(List<Node> nodes, TextWriter output)
+		{
+			_writer = new(output);
 
 			foreach (var node in nodes)
 			{
 				node.Visit(_writer, isExpression: false);
 			}
-
-			return _writer.Stream;
 		}
 	}
 }
@@ -14,10 +14,17 @@ namespace DSO.CodeGenerator
 {
 	public delegate bool ShouldAddParentheses(Node node);
 
-	public class CodeWriter
+	/// <summary>
+	/// Writes code tokens straight to a <see cref="TextWriter"/>, handling indentation along the way.
+	/// </summary>
+	public class CodeWriter(TextWriter writer)
 	{
+		static private readonly string[] _indents = Enumerable.Range(0, 16).Select(indent => new string('\t', indent)).ToArray();
+
+		static private string GetIndent(int indent) => indent < _indents.Length ? _indents[indent] : new('\t', indent);
+
+		private readonly TextWriter _writer = writer;
 		private string _prevToken = "";
-		public readonly List<string> Stream = [];
 
 		public int Indent { get; private set; } = 0;
 
@@ -30,12 +37,9 @@ namespace DSO.CodeGenerator
 					Indent--;
 				}
 
-				if (_prevToken == "\n" && token != "\n")
+				if (_prevToken == "\n" && token != "\n" && Indent > 0)
 				{
-					for (var i = 0; i < Indent; i++)
-					{
-						Stream.Add("\t");
-					}
+					_writer.Write(GetIndent(Indent));
 				}
 
 				if (token == "{")
@@ -45,7 +49,7 @@ namespace DSO.CodeGenerator
 
 				_prevToken = token;
 
-				Stream.Add(token);
+				_writer.Write(token);
 			}
 		}
 
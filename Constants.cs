@@ -17,6 +17,11 @@ namespace DSO.Constants
 		public const string VERSION = "2.1.0";
 		public const string EXTENSION = ".dso";
 		public const string DISASM_EXTENSION = ".disasm";
+		public const int OUTPUT_BUFFER_SIZE = 64 * 1024;
+		public const string CACHE_FILE_NAME = ".dso-sharp-cache";
+		public const string ARCHIVE_EXTENSION = ".zip";
+		public const string ARCHIVE_OUTPUT_SUFFIX = "_decompiled";
+		public const string TEMP_EXTENSION = ".tmp";
 
 		static public class GameVersions
 		{
@@ -9,6 +9,7 @@
  */
 
 using DSO.Disassembler;
+using DSO.Opcodes;
 
 namespace DSO.ControlFlow
 {
@@ -38,15 +39,89 @@ namespace DSO.ControlFlow
 		}
 
 		public void AddBranch(ControlFlowBranch branch) => Branches[branch.StartAddress] = branch;
+
+		/// <summary>
+		/// Moves the blocks and branches in each range out into their own data, so the ranges can be built
+		/// separately. The ranges have to be sorted and can't overlap, and their ends are exclusive.
+		/// </summary>
+		public ControlFlowData[] Split(IReadOnlyList<(uint Start, uint End)> ranges)
+		{
+			var split = new ControlFlowData[ranges.Count];
+
+			for (var i = 0; i < split.Length; i++)
+			{
+				split[i] = new();
+			}
+
+			foreach (var address in Blocks.Keys.ToArray())
+			{
+				var index = FindRange(ranges, address);
+
+				if (index >= 0)
+				{
+					split[index].Blocks[address] = Blocks[address];
+					Blocks.Remove(address);
+				}
+			}
+
+			foreach (var address in Branches.Keys.ToArray())
+			{
+				var index = FindRange(ranges, address);
+
+				if (index >= 0)
+				{
+					split[index].Branches[address] = Branches[address];
+					Branches.Remove(address);
+				}
+			}
+
+			return split;
+		}
+
+		static private int FindRange(IReadOnlyList<(uint Start, uint End)> ranges, uint address)
+		{
+			var low = 0;
+			var high = ranges.Count - 1;
+
+			while (low <= high)
+			{
+				var middle = low + (high - low) / 2;
+				var (start, end) = ranges[middle];
+
+				if (address < start)
+				{
+					high = middle - 1;
+				}
+				else if (address >= end)
+				{
+					low = middle + 1;
+				}
+				else
+				{
+					return middle;
+				}
+			}
+
+			return -1;
+		}
 	}
 
+	/// <summary>
+	/// Finds the if statements and loops in the code, and what each unconditional jump is (an else, a break, or a
+	/// continue), for the <see cref="AST.Builder"/> to use.<br/><br/>
+	///
+	/// The blocks themselves come straight from the conditional branches, since the compiler always emits them the
+	/// same way. The dominator tree of the <see cref="ControlFlowGraph"/> is used to reject loops that can be jumped
+	/// into from the middle, which would otherwise fail somewhere much less obvious. The graph is only built for
+	/// files that have loops in them.
+	/// </summary>
 	public class ControlFlowAnalyzer
 	{
 		public ControlFlowData Analyze(Disassembly disassembly)
 		{
 			var root = BuildControlFlowBlocks(disassembly);
 
-			AnalyzeBranches(root);
+			AnalyzeBranches(root, outerLoop: null);
 
 			return FlattenBlocks(root);
 		}
@@ -62,6 +137,8 @@ namespace DSO.ControlFlow
 
 		private ControlFlowBlock BuildControlFlowBlocks(Disassembly disassembly)
 		{
+			ControlFlowGraph? graph = null;
+
 			var blocks = new List<ControlFlowBlock>()
 			{
 				new(ControlFlowBlockType.Root, disassembly.First, disassembly.Last),
@@ -71,9 +148,24 @@ namespace DSO.ControlFlow
 			{
 				if (branch.IsConditional && !branch.IsLogicalOperator)
 				{
+					var target = disassembly.GetInstruction(branch.TargetAddress)
+						?? throw new ControlFlowAnalyzerException($"Branch at {branch.Address} jumps to invalid address {branch.TargetAddress}");
+
+					if (branch.IsLoopEnd)
+					{
+						graph ??= new(disassembly);
+
+						// A loop is only a loop if the only way into it is through the top. Nothing dominates code that
+						// can't be reached (like code after a return), so there's nothing to check there.
+						if (graph.IsReachable(branch.Address) && !graph.Dominates(target.Address, branch.Address))
+						{
+							throw new ControlFlowAnalyzerException($"Branch at {branch.Address} jumps backwards into the middle of a block");
+						}
+					}
+
 					var type = branch.IsLoopEnd ? ControlFlowBlockType.Loop : ControlFlowBlockType.Conditional;
-					var start = branch.IsLoopEnd ? disassembly.GetInstruction(branch.TargetAddress) : branch;
-					var end = branch.IsLoopEnd ? branch : disassembly.GetInstruction(branch.TargetAddress).Prev;
+					var start = branch.IsLoopEnd ? target : branch;
+					var end = branch.IsLoopEnd ? branch : target.Prev;
 
 					blocks.Add(new(type, start, end));
 				}
@@ -102,23 +194,27 @@ namespace DSO.ControlFlow
 			var blockStack = new Stack<ControlFlowBlock>();
 			var blockIndex = 0;
 
-			foreach (var instruction in disassembly)
+			var stream = disassembly.Stream;
+
+			for (var index = 0; index < stream.Count; index++)
 			{
-				while (blockStack.Count > 0 && blockStack.Peek().End.Address < instruction.Address)
+				var address = stream.GetAddress(index);
+
+				while (blockStack.Count > 0 && blockStack.Peek().End.Address < address)
 				{
 					var popped = blockStack.Pop();
 
 					blockStack.Peek().AddChild(popped);
 				}
 
-				while (blockIndex < blocks.Count && blocks[blockIndex].Start.Address == instruction.Address)
+				while (blockIndex < blocks.Count && blocks[blockIndex].Start.Address == address)
 				{
 					blockStack.Push(blocks[blockIndex++]);
 				}
 
-				if (instruction is BranchInstruction branch && branch.IsUnconditional)
+				if (stream.GetTag(index) == OpcodeTag.OP_JMP)
 				{
-					blockStack.Peek().AddBranch(branch);
+					blockStack.Peek().AddBranch((BranchInstruction) disassembly[index]);
 				}
 			}
 
@@ -130,52 +226,57 @@ namespace DSO.ControlFlow
 			return blockStack.Pop();
 		}
 
-		private void AnalyzeBranches(ControlFlowBlock block)
+		private void AnalyzeBranches(ControlFlowBlock block, ControlFlowBlock? outerLoop)
 		{
-			var outerLoop = block.FindOuterLoop();
-			var parent = block.Parent;
+			var loop = block.Type == ControlFlowBlockType.Loop ? block : outerLoop;
 
 			foreach (var branch in block.Branches.Values)
 			{
-				if (block.Type == ControlFlowBlockType.Loop)
-				{
-					// If the OP_JMP is just directly in a loop, it's a continue.
-					branch.Type = branch.TargetAddress <= block.End.Address ? ControlFlowBranchType.Continue : ControlFlowBranchType.Break;
-				}
-				else if (block.Type == ControlFlowBlockType.Conditional && outerLoop != null)
-				{
-					if (branch.TargetAddress == outerLoop.End.Next?.Address)
-					{
-						branch.Type = ControlFlowBranchType.Break;
-					}
-					else if (branch.StartAddress < block.End.Address)
-					{
-						// If the branch is in a conditional, but it's not at the end, it's a continue.
-						branch.Type = ControlFlowBranchType.Continue;
-					}
-					else if (parent != null && parent.Type == ControlFlowBlockType.Conditional && branch.TargetAddress > parent.End.Next?.Address)
-					{
-						// If the parent is a conditional, and the destination is higher than its end, it's a continue.
-						branch.Type = ControlFlowBranchType.Continue;
-					}
-				}
+				branch.Type = GetBranchType(block, branch, loop);
+			}
 
-				if (branch.Type == ControlFlowBranchType.Continue)
-				{
-					block.ContinuePoint = branch.TargetAddress;
-				}
+			block.Children.ForEach(child => AnalyzeBranches(child, loop));
+		}
+
+		private ControlFlowBranchType GetBranchType(ControlFlowBlock block, ControlFlowBranch branch, ControlFlowBlock? loop)
+		{
+			if (loop != null && branch.TargetAddress == loop.End.Next?.Address)
+			{
+				return ControlFlowBranchType.Break;
 			}
 
-			// Once the continue point has been determined (if there is one), we can set all branches to it as continues, just in case.
-			foreach (var branch in block.Branches.Values)
+			if (IsElse(block, branch))
 			{
-				if (outerLoop != null && branch.TargetAddress == outerLoop.ContinuePoint)
-				{
-					branch.Type = ControlFlowBranchType.Continue;
-				}
+				return ControlFlowBranchType.Else;
 			}
 
-			block.Children.ForEach(AnalyzeBranches);
+			if (loop != null && branch.TargetAddress >= loop.Start.Address && branch.TargetAddress <= loop.End.Address)
+			{
+				return ControlFlowBranchType.Continue;
+			}
+
+			return ControlFlowBranchType.Else;
+		}
+
+		/// <summary>
+		/// A jump at the end of an if statement skips over its else, as long as the else fits in whatever the if
+		/// statement is in.<br/><br/>
+		///
+		/// Post-dominators can't tell us this: if either side of the if ends with a break, continue, or return, the
+		/// two sides never meet back up (or only meet at the bottom of the loop), and the jump that skips the else
+		/// looks just like a continue. A jump at the end of an if that really was a continue, like the one in
+		/// <c>if (%a) continue; %b = 1;</c> at the end of a loop, does the same thing as an else anyway.
+		/// </summary>
+		static private bool IsElse(ControlFlowBlock block, ControlFlowBranch branch)
+		{
+			if (block.Type != ControlFlowBlockType.Conditional || branch.StartAddress != block.End.Address)
+			{
+				return false;
+			}
+
+			var parentEnd = block.Parent?.End.Next?.Address;
+
+			return parentEnd == null || branch.TargetAddress <= parentEnd;
 		}
 
 		private void FlattenBlocks(ControlFlowBlock block, ControlFlowData data)
@@ -42,7 +42,6 @@ namespace DSO.ControlFlow
 		public readonly List<ControlFlowBlock> Children = [];
 		public readonly Dictionary<uint, ControlFlowBranch> Branches = [];
 
-		public uint? ContinuePoint { get; set; } = null;
 		public ControlFlowBlock? Parent { get; set; } = null;
 
 		public void AddBranch(BranchInstruction branch)
@@ -56,20 +55,5 @@ namespace DSO.ControlFlow
 
 			Children.Add(child);
 		}
-
-		public ControlFlowBlock? FindOuterLoop()
-		{
-			if (Parent == null)
-			{
-				return null;
-			}
-
-			if (Parent.Type == ControlFlowBlockType.Loop)
-			{
-				return Parent;
-			}
-
-			return Parent.FindOuterLoop();
-		}
 	}
 }
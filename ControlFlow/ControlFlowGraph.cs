@@ -0,0 +1,419 @@
+﻿/**
+ * ControlFlowGraph.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.Disassembler;
+using DSO.Opcodes;
+
+namespace DSO.ControlFlow
+{
+	/// <summary>
+	/// A graph of the basic blocks in a file, along with its dominator tree.<br/><br/>
+	///
+	/// Node 0 is a virtual entry that leads to the start of the file and to the start of every function body, and
+	/// the last node is a virtual exit that every return leads to. Function declarations at the top level lead
+	/// straight to the instruction after the function, since that's where execution actually goes.<br/><br/>
+	///
+	/// The tree is built with the algorithm from Cooper, Harvey, and Kennedy's "A Simple, Fast Dominance
+	/// Algorithm", which is close to linear on the kind of graphs that a compiler for a structured language emits.
+	/// </summary>
+	public class ControlFlowGraph
+	{
+		/// <summary>
+		/// Edges stored back-to-back in one array, with the edges of each node starting at its offset.
+		/// </summary>
+		private class Adjacency
+		{
+			private readonly int[] _offsets;
+			private readonly int[] _targets;
+
+			public int Count => _offsets.Length - 1;
+
+			public ReadOnlySpan<int> this[int node] => _targets.AsSpan(_offsets[node], _offsets[node + 1] - _offsets[node]);
+
+			public Adjacency(int count, List<(int From, int To)> edges, bool reverse = false)
+			{
+				_offsets = new int[count + 1];
+				_targets = new int[edges.Count];
+
+				foreach (var (from, to) in edges)
+				{
+					_offsets[(reverse ? to : from) + 1]++;
+				}
+
+				for (var node = 0; node < count; node++)
+				{
+					_offsets[node + 1] += _offsets[node];
+				}
+
+				var positions = _offsets[..^1];
+
+				foreach (var (from, to) in edges)
+				{
+					_targets[positions[reverse ? to : from]++] = reverse ? from : to;
+				}
+			}
+		}
+
+		private const int UNDEFINED = -1;
+
+		private readonly InstructionStream _stream;
+
+		/// <summary>
+		/// The node that each instruction belongs to, indexed the same as <see cref="InstructionStream"/>.
+		/// </summary>
+		private readonly int[] _nodes;
+
+		/// <summary>
+		/// The index of the first instruction of each node, with the virtual entry and exit set to -1.
+		/// </summary>
+		private readonly int[] _starts;
+
+		private readonly Adjacency _successors;
+		private readonly Adjacency _predecessors;
+
+		private readonly int[] _dominators;
+
+		/// <summary>
+		/// Preorder and postorder numbers in the dominator tree, so we can check dominance in constant time.
+		/// </summary>
+		private readonly int[] _preorder;
+		private readonly int[] _postorder;
+
+		public int Count => _starts.Length;
+
+		private int Entry => 0;
+		private int Exit => _starts.Length - 1;
+
+		public ControlFlowGraph(Disassembly disassembly)
+		{
+			_stream = disassembly.Stream;
+			_nodes = new int[_stream.Count];
+
+			var leaders = FindLeaders(disassembly);
+			var starts = new List<int> { UNDEFINED };
+
+			for (var index = 0; index < _stream.Count; index++)
+			{
+				if (leaders[index])
+				{
+					starts.Add(index);
+				}
+
+				_nodes[index] = starts.Count - 1;
+			}
+
+			starts.Add(UNDEFINED);
+
+			_starts = [.. starts];
+
+			var edges = FindEdges(disassembly);
+
+			_successors = new(_starts.Length, edges);
+			_predecessors = new(_starts.Length, edges, reverse: true);
+
+			_dominators = FindDominators(Entry, _successors, _predecessors);
+
+			(_preorder, _postorder) = NumberTree(_dominators, Entry);
+		}
+
+		/// <summary>
+		/// Whether every path from the start of the file or function to <paramref name="address"/> goes through
+		/// <paramref name="dominator"/>.
+		/// </summary>
+		public bool Dominates(uint dominator, uint address)
+		{
+			var dominatorIndex = _stream.IndexOf(dominator);
+			var index = _stream.IndexOf(address);
+
+			if (dominatorIndex < 0 || index < 0)
+			{
+				return false;
+			}
+
+			var node1 = _nodes[dominatorIndex];
+			var node2 = _nodes[index];
+
+			if (node1 == node2)
+			{
+				return dominatorIndex <= index;
+			}
+
+			// Unreachable code isn't in the tree, so nothing dominates it.
+			if (_preorder[node2] == UNDEFINED)
+			{
+				return false;
+			}
+
+			return _preorder[node1] <= _preorder[node2] && _postorder[node2] <= _postorder[node1];
+		}
+
+		/// <summary>
+		/// Whether there's any way to get to <paramref name="address"/> at all, and not just code after a return.
+		/// </summary>
+		public bool IsReachable(uint address) => _stream.IndexOf(address) is int index && index >= 0 && _preorder[_nodes[index]] != UNDEFINED;
+
+		private bool[] FindLeaders(Disassembly disassembly)
+		{
+			var leaders = new bool[_stream.Count + 1];
+
+			leaders[0] = true;
+
+			for (var index = 0; index < _stream.Count; index++)
+			{
+				var instruction = disassembly[index];
+
+				switch (instruction)
+				{
+					case BranchInstruction branch:
+						MarkLeader(leaders, branch.TargetAddress);
+						leaders[index + 1] = true;
+						break;
+
+					case FunctionInstruction function when function.HasBody:
+						MarkLeader(leaders, function.EndAddress);
+						leaders[index + 1] = true;
+						break;
+
+					case CreateObjectInstruction create:
+						MarkLeader(leaders, create.FailJumpAddress);
+						leaders[index + 1] = true;
+						break;
+
+					case ReturnInstruction:
+						leaders[index + 1] = true;
+						break;
+				}
+			}
+
+			return leaders;
+		}
+
+		private void MarkLeader(bool[] leaders, uint address)
+		{
+			var index = _stream.IndexOf(address);
+
+			if (index >= 0)
+			{
+				leaders[index] = true;
+			}
+		}
+
+		private List<(int From, int To)> FindEdges(Disassembly disassembly)
+		{
+			var edges = new List<(int From, int To)>(_starts.Length * 2);
+
+			void AddEdge(int from, int to) => edges.Add((from, to));
+
+			if (_stream.Count > 0)
+			{
+				AddEdge(Entry, _nodes[0]);
+			}
+
+			for (var node = 1; node < Exit; node++)
+			{
+				var last = (node + 1 < Exit ? _starts[node + 1] : _stream.Count) - 1;
+				var next = last + 1 < _stream.Count ? _nodes[last + 1] : Exit;
+
+				switch (disassembly[last])
+				{
+					case BranchInstruction branch:
+						AddEdge(node, GetNode(branch.TargetAddress));
+
+						if (branch.IsConditional)
+						{
+							AddEdge(node, next);
+						}
+
+						break;
+
+					case FunctionInstruction function when function.HasBody:
+						AddEdge(node, GetNode(function.EndAddress));
+						AddEdge(Entry, next);
+						break;
+
+					case CreateObjectInstruction create:
+						AddEdge(node, next);
+						AddEdge(node, GetNode(create.FailJumpAddress));
+						break;
+
+					case ReturnInstruction:
+						AddEdge(node, Exit);
+						break;
+
+					default:
+						AddEdge(node, next);
+						break;
+				}
+			}
+
+			return edges;
+		}
+
+		/// <summary>
+		/// Jumps to addresses that aren't instructions (like the end of the code) are treated as leaving the function.
+		/// </summary>
+		private int GetNode(uint address) => _stream.IndexOf(address) is int index && index >= 0 ? _nodes[index] : Exit;
+
+		/// <summary>
+		/// Finds the immediate dominator of every node reachable from <paramref name="root"/>.
+		/// </summary>
+		static private int[] FindDominators(int root, Adjacency successors, Adjacency predecessors)
+		{
+			var dominators = new int[successors.Count];
+			var (order, postorder) = FindPostorder(root, successors);
+
+			Array.Fill(dominators, UNDEFINED);
+			dominators[root] = root;
+
+			var changed = true;
+
+			while (changed)
+			{
+				changed = false;
+
+				// Reverse postorder, skipping the root (which is always last in postorder).
+				for (var i = order.Count - 2; i >= 0; i--)
+				{
+					var node = order[i];
+					var dominator = UNDEFINED;
+
+					foreach (var predecessor in predecessors[node])
+					{
+						if (dominators[predecessor] == UNDEFINED)
+						{
+							continue;
+						}
+
+						dominator = dominator == UNDEFINED ? predecessor : Intersect(predecessor, dominator, dominators, postorder);
+					}
+
+					if (dominators[node] != dominator)
+					{
+						dominators[node] = dominator;
+						changed = true;
+					}
+				}
+			}
+
+			return dominators;
+		}
+
+		static private int Intersect(int node1, int node2, int[] dominators, int[] postorder)
+		{
+			while (node1 != node2)
+			{
+				while (postorder[node1] < postorder[node2])
+				{
+					node1 = dominators[node1];
+				}
+
+				while (postorder[node2] < postorder[node1])
+				{
+					node2 = dominators[node2];
+				}
+			}
+
+			return node1;
+		}
+
+		/// <summary>
+		/// Returns the nodes reachable from <paramref name="root"/> in postorder, as well as each node's position in
+		/// that order (or -1 for unreachable nodes).
+		/// </summary>
+		static private Tuple<List<int>, int[]> FindPostorder(int root, Adjacency successors)
+		{
+			var order = new List<int>();
+			var numbers = new int[successors.Count];
+			var visited = new bool[successors.Count];
+			var stack = new Stack<(int Node, int Edge)>();
+
+			Array.Fill(numbers, UNDEFINED);
+
+			visited[root] = true;
+			stack.Push((root, 0));
+
+			while (stack.Count > 0)
+			{
+				var (node, edge) = stack.Pop();
+
+				if (edge < successors[node].Length)
+				{
+					stack.Push((node, edge + 1));
+
+					var successor = successors[node][edge];
+
+					if (!visited[successor])
+					{
+						visited[successor] = true;
+						stack.Push((successor, 0));
+					}
+				}
+				else
+				{
+					numbers[node] = order.Count;
+					order.Add(node);
+				}
+			}
+
+			return new(order, numbers);
+		}
+
+		/// <summary>
+		/// Numbers the nodes of the tree described by <paramref name="parents"/> in preorder and postorder.
+		/// </summary>
+		static private Tuple<int[], int[]> NumberTree(int[] parents, int root)
+		{
+			var edges = new List<(int From, int To)>(parents.Length);
+			var preorder = new int[parents.Length];
+			var postorder = new int[parents.Length];
+
+			Array.Fill(preorder, UNDEFINED);
+			Array.Fill(postorder, UNDEFINED);
+
+			for (var node = 0; node < parents.Length; node++)
+			{
+				if (node != root && parents[node] != UNDEFINED)
+				{
+					edges.Add((parents[node], node));
+				}
+			}
+
+			var children = new Adjacency(parents.Length, edges);
+
+			var stack = new Stack<(int Node, int Child)>();
+			var preorderNumber = 0;
+			var postorderNumber = 0;
+
+			preorder[root] = preorderNumber++;
+			stack.Push((root, 0));
+
+			while (stack.Count > 0)
+			{
+				var (node, child) = stack.Pop();
+
+				if (child < children[node].Length)
+				{
+					stack.Push((node, child + 1));
+
+					var next = children[node][child];
+
+					preorder[next] = preorderNumber++;
+					stack.Push((next, 0));
+				}
+				else
+				{
+					postorder[node] = postorderNumber++;
+				}
+			}
+
+			return new(preorder, postorder);
+		}
+	}
+}
@@ -15,6 +15,9 @@ using DSO.Disassembler;
 using DSO.Loader;
 using DSO.Util;
 using DSO.Versions;
+using System.Collections.Concurrent;
+using System.IO.Compression;
+using System.Text;
 using static DSO.Constants.Decompiler;
 using static DSO.Util.CommandLineOptions;
 
@@ -27,18 +30,64 @@ namespace DSO
 		public DecompilerException(string message, Exception inner) : base(message, inner) { }
 	}
 
+	/// <summary>
+	/// Options for decompiling a file in memory (see <see cref="Decompiler.Decompile(ReadOnlyMemory{byte}, GameIdentifier, DecompileOptions?)"/>).
+	/// </summary>
+	public class DecompileOptions
+	{
+		public bool Script { get; set; } = true;
+		public bool Disassembly { get; set; } = false;
+		public bool ParallelFunctions { get; set; } = false;
+	}
+
+	public class DecompileResult(GameIdentifier game, string? script, string? disassembly, List<string> warnings)
+	{
+		/// <summary>
+		/// The game the file was decompiled as, which is only different from the one passed in if that was
+		/// <see cref="GameIdentifier.Auto"/>.
+		/// </summary>
+		public readonly GameIdentifier Game = game;
+
+		public readonly string? Script = script;
+		public readonly string? Disassembly = disassembly;
+		public readonly List<string> Warnings = warnings;
+	}
+
 	public class Decompiler
 	{
-		private CommandLineOptions _options;
+		/// <summary>
+		/// UTF-8 without a byte order mark, same as <see cref="File.WriteAllText(string, string?)"/>.
+		/// </summary>
+		static private readonly UTF8Encoding _encoding = new(encoderShouldEmitUTF8Identifier: false);
 
-		public void Decompile(CommandLineOptions options)
+		private CommandLineOptions _options;
+		private readonly Dictionary<string, OutputCache> _caches = [];
+
+		/// <summary>
+		/// Which file each output path in this run belongs to (see <see cref="FindOutputConflict"/>).
+		/// </summary>
+		private readonly ConcurrentDictionary<string, string> _outputPaths = new(OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal);
+		private StatisticsReport? _report = null;
+		private SymbolIndex? _index = null;
+		private readonly BuilderPool _builders = new();
+		private readonly NodeListArenaPool _arenas = new();
+
+		/// <summary>
+		/// Can be called any number of times. Caches that were already loaded stay loaded between calls.
+		/// </summary>
+		/// <returns>
+		/// How many files we tried to decompile and how many of them failed, or null if the paths were invalid.
+		/// </returns>
+		public Tuple<int, int>? Decompile(CommandLineOptions options)
 		{
 			if (options.Paths.Count <= 0)
 			{
-				return;
+				return null;
 			}
 
 			_options = options;
+			_report = options.StatisticsPath != null ? new() : null;
+			_outputPaths.Clear();
 
 			var startTime = DateTimeOffset.Now.ToUnixTimeMilliseconds();
 
@@ -46,35 +95,50 @@ namespace DSO
 			{
 				if (Path.HasExtension(path))
 				{
-					if (Path.GetExtension(path) != EXTENSION)
+					if (Path.GetExtension(path) != EXTENSION && !IsArchive(path))
 					{
-						Logger.LogError($"File \"{path}\" does not have a `{EXTENSION}` extension");
-						return;
+						Logger.LogError($"File \"{path}\" does not have a `{EXTENSION}` or `{ARCHIVE_EXTENSION}` extension");
+						return null;
 					}
 
 					if (!File.Exists(path))
 					{
 						Logger.LogError($"File \"{path}\" does not exist at the path specified");
-						return;
+						return null;
 					}
 				}
 				else if (!Directory.Exists(path))
 				{
 					Logger.LogError($"Directory \"{path}\" does not exist at the path specified");
-					return;
+					return null;
+				}
+			}
+
+			if (options.OutputPath != null && options.IndexPath == null)
+			{
+				try
+				{
+					Directory.CreateDirectory(options.OutputPath);
+				}
+				catch (Exception exception)
+				{
+					Logger.LogError($"Could not create output directory \"{options.OutputPath}\": {exception.Message}");
+					return null;
 				}
 			}
 
+			_index = options.IndexPath != null ? SymbolIndex.Load(options.IndexPath) : null;
+
 			var files = 0;
 			var failures = 0;
 
 			foreach (var path in options.Paths)
 			{
-				if (Path.HasExtension(path))
+				if (Path.HasExtension(path) && !IsArchive(path))
 				{
 					files++;
 
-					if (!DecompileFile(path))
+					if (!DecompileFile(path, root: null, OpenCache(_options.OutputPath ?? Path.GetDirectoryName(Path.GetFullPath(path))!)))
 					{
 						failures++;
 					}
@@ -86,71 +150,459 @@ namespace DSO
 						Logger.LogMessage("");
 					}
 
-					var result = DecompileDirectory(path);
+					var result = IsArchive(path) ? DecompileArchive(path) : DecompileDirectory(path);
 
 					files += result.Item1;
 					failures += result.Item2;
 				}
 			}
 
+			foreach (var cache in _caches.Values)
+			{
+				cache.Save();
+			}
+
 			var totalTime = DateTimeOffset.Now.ToUnixTimeMilliseconds() - startTime;
 			var plural = files != 1;
 
+			if (_index != null)
+			{
+				WriteIndex(options.IndexPath!);
+			}
+
+			if (_report != null)
+			{
+				WriteStatistics(options.StatisticsPath!, totalTime);
+			}
+
 			Logger.LogMessage("");
 
-			var verb = _options.OutputDisassembly == DisassemblyOutput.DisassemblyOnly ? "Disassemble" : "Decompile";
+			var (verb, _, pastVerb) = GetVerbs();
 
 			if (failures <= 0)
 			{
-				Logger.LogSuccess($"{verb}d {files} file{(plural ? "s" : "")} successfully in {totalTime} ms\n");
+				Logger.LogSuccess($"{pastVerb} {files} file{(plural ? "s" : "")} successfully in {totalTime} ms\n");
 			}
 			else if (failures < files)
 			{
-				Logger.LogWarning($"{verb}d {files - failures} of {files} file{(plural ? "s" : "")} in {totalTime} ms");
+				Logger.LogWarning($"{pastVerb} {files - failures} of {files} file{(plural ? "s" : "")} in {totalTime} ms");
 			}
 			else
 			{
-				Logger.LogError($"Failed to {verb.ToLower()} {(plural ? "all " : "")}{files} file{(plural ? "s" : "")}");
+				Logger.LogError($"Failed to {verb} {(plural ? "all " : "")}{files} file{(plural ? "s" : "")}");
+			}
+
+			return new(files, failures);
+		}
+
+		/// <summary>
+		/// Decompiles a file that's already in memory, and returns the script and/or disassembly as strings instead
+		/// of writing them anywhere. Nothing gets read from or written to the disk, and nothing gets logged.<br/><br/>
+		///
+		/// Safe to call from multiple threads at once on the same instance.
+		/// </summary>
+		/// <exception cref="DecompilerException">
+		/// Throws if the game couldn't be detected, or if decompiling failed (with the original exception inside).
+		/// </exception>
+		public DecompileResult Decompile(ReadOnlyMemory<byte> bytes, GameIdentifier identifier, DecompileOptions? options = null)
+		{
+			options ??= new();
+
+			var warnings = new List<string>();
+			FileData? data = null;
+
+			try
+			{
+				if (identifier == GameIdentifier.Auto)
+				{
+					var identifiers = GameVersion.GetIdentifiersFromVersion(FileLoader.ReadFileVersion(bytes.Span));
+
+					if (identifiers.Length <= 0)
+					{
+						throw new DecompilerException("Could not automatically identify game from file");
+					}
+
+					(identifier, data) = identifiers.Length == 1 ? new(identifiers[0], null) : DetectGame(bytes, identifiers);
+				}
+
+				return _arenas.Use(arena =>
+				{
+					var (game, fileData, disassembly, nodes) = Parse(bytes, identifier, data, build: options.Script, options.ParallelFunctions, stats: null, warnings, arena);
+
+					string? script = null;
+					string? disassemblyText = null;
+
+					if (options.Script)
+					{
+						var writer = new StringWriter();
+
+						new CodeGenerator.CodeGenerator().Generate(nodes, writer);
+						script = writer.ToString();
+					}
+
+					if (options.Disassembly)
+					{
+						var writer = new StringWriter();
+						var disassemblyWriter = new DisassemblyWriter(writer);
+
+						disassemblyWriter.WriteHeader(game, fileData);
+						disassembly.Visit(disassemblyWriter);
+						disassemblyText = writer.ToString();
+					}
+
+					return new DecompileResult(identifier, script, disassemblyText, warnings);
+				});
+			}
+			catch (DecompilerException)
+			{
+				throw;
+			}
+			catch (Exception exception)
+			{
+				throw new DecompilerException(exception.Message, exception);
 			}
 		}
 
 		private Tuple<int, int> DecompileDirectory(string path)
 		{
-			Logger.LogMessage($"{(_options.OutputDisassembly == DisassemblyOutput.DisassemblyOnly ? "Disassembling" : "Decompiling")} all files in directory: \"{path}\"");
+			Logger.LogMessage($"{GetVerbs().Item2} all files in directory: \"{path}\"");
 
 			var files = Directory.GetFiles(path, $"*{EXTENSION}", SearchOption.AllDirectories);
+			var cache = OpenCache(_options.OutputPath ?? path);
+
+			if (!CreateOutputDirectories(files.Select(file => GetScriptPath(file, path))))
+			{
+				return new(files.Length, files.Length);
+			}
+
+			var failures = DecompileFiles(files.Length, index => DecompileFile(files[index], path, cache));
+
+			return new(files.Length, failures);
+		}
+
+		/// <summary>
+		/// Decompiles the DSO files in a zip archive straight from memory, without extracting them first. When
+		/// decompiling in parallel, each thread opens the archive separately so entries can be decompressed at the
+		/// same time.<br/><br/>
+		///
+		/// The output files all go into a new archive next to this one (see <see cref="ArchiveOutput"/>).
+		/// </summary>
+		private Tuple<int, int> DecompileArchive(string path)
+		{
+			Logger.LogMessage($"{GetVerbs().Item2} all files in archive: \"{path}\"");
+
+			string[] names;
+
+			try
+			{
+				using var archive = ZipFile.OpenRead(path);
+
+				names = archive.Entries
+					.Select(entry => entry.FullName)
+					.Where(name => name.EndsWith(EXTENSION, StringComparison.OrdinalIgnoreCase))
+					.ToArray();
+			}
+			catch (Exception exception)
+			{
+				Logger.LogError(exception.Message);
+
+				return new(1, 1);
+			}
+
+			var output = new ArchiveOutput(path, _options.OutputPath, _encoding);
+
+			if (FindOutputConflict(output.OutputPath, path) is string conflict)
+			{
+				Logger.LogError($"Output archive \"{output.OutputPath}\" would overwrite the output of \"{conflict}\"");
+
+				return new(names.Length, names.Length);
+			}
+
+			int failures;
+
+			using (var readers = new ThreadLocal<ZipArchive>(() => ZipFile.OpenRead(path), trackAllValues: true))
+			{
+				try
+				{
+					failures = DecompileFiles(names.Length, index =>
+					{
+						var name = names[index];
+
+						var entryPath = Path.Join(path, name);
+						var scriptPath = Path.Join(Path.GetDirectoryName(entryPath), Path.GetFileNameWithoutExtension(entryPath));
+
+						return DecompileFile(entryPath, scriptPath, () => ReadArchiveEntry(readers.Value!, name), cache: null, output);
+					});
+				}
+				finally
+				{
+					foreach (var reader in readers.Values)
+					{
+						reader.Dispose();
+					}
+				}
+			}
+
+			if (output.Count > 0)
+			{
+				Logger.LogMessage($"Writing output archive: \"{output.OutputPath}\"");
+
+				try
+				{
+					output.Save();
+				}
+				catch (Exception exception)
+				{
+					Logger.LogError(exception.Message);
+
+					failures = names.Length;
+				}
+			}
+
+			return new(names.Length, failures);
+		}
+
+		static private byte[] ReadArchiveEntry(ZipArchive archive, string name)
+		{
+			var entry = archive.GetEntry(name) ?? throw new DecompilerException($"Archive entry \"{name}\" could not be found");
+			var bytes = new byte[checked((int) entry.Length)];
+
+			using var stream = entry.Open();
+
+			stream.ReadExactly(bytes);
+
+			return bytes;
+		}
+
+		/// <summary>
+		/// What we're doing to the files, for the log: the verb itself, then its "-ing" and past forms.
+		/// </summary>
+		private Tuple<string, string, string> GetVerbs()
+		{
+			if (_index != null)
+			{
+				return new("index", "Indexing", "Indexed");
+			}
+
+			return _options.OutputDisassembly == DisassemblyOutput.DisassemblyOnly
+				? new("disassemble", "Disassembling", "Disassembled")
+				: new("decompile", "Decompiling", "Decompiled");
+		}
+
+		static private bool IsArchive(string path) => Path.GetExtension(path).Equals(ARCHIVE_EXTENSION, StringComparison.OrdinalIgnoreCase);
+
+		/// <summary>
+		/// Calls <paramref name="decompile"/> for each file, on multiple threads if <see cref="CommandLineOptions.Jobs"/>
+		/// is more than 1, and returns how many of them failed.
+		/// </summary>
+		private int DecompileFiles(int count, Func<int, bool> decompile)
+		{
+			if (_options.Jobs > 1)
+			{
+				return DecompileFilesParallel(count, decompile);
+			}
+
 			var failures = 0;
 
-			foreach (var file in files)
+			for (var i = 0; i < count; i++)
 			{
-				if (!DecompileFile(file))
+				if (!decompile(i))
 				{
 					failures++;
 				}
 			}
 
-			return new(files.Length, failures);
+			return failures;
+		}
+
+		/// <summary>
+		/// Decompiles files on up to <see cref="CommandLineOptions.Jobs"/> threads at once.<br/><br/>
+		///
+		/// Every file already gets its own loader, bytecode reader, builder, and code generator, so the only
+		/// thing the threads share is the log. Each file's messages are buffered and flushed in the same order
+		/// that they would have been printed in if we had decompiled the files one at a time.
+		/// </summary>
+		private int DecompileFilesParallel(int count, Func<int, bool> decompile)
+		{
+			var logs = new List<LogEntry>?[count];
+			var flushLock = new object();
+			var flushed = 0;
+			var failures = 0;
+
+			// Hand out files one at a time and in order, so a slow file doesn't hold up a whole chunk of them.
+			var partitioner = Partitioner.Create(Enumerable.Range(0, count), EnumerablePartitionerOptions.NoBuffering);
+			var parallelOptions = new ParallelOptions { MaxDegreeOfParallelism = _options.Jobs };
+
+			Parallel.ForEach(partitioner, parallelOptions, index =>
+			{
+				var success = false;
+
+				Logger.BeginBuffer();
+
+				try
+				{
+					success = decompile(index);
+				}
+				catch (Exception exception)
+				{
+					Logger.LogError(exception.Message);
+				}
+
+				var log = Logger.EndBuffer();
+
+				if (!success)
+				{
+					Interlocked.Increment(ref failures);
+				}
+
+				lock (flushLock)
+				{
+					logs[index] = log;
+
+					while (flushed < logs.Length && logs[flushed] is List<LogEntry> next)
+					{
+						Logger.Flush(next);
+						logs[flushed++] = null;
+					}
+				}
+			});
+
+			return failures;
 		}
 
-		private bool DecompileFile(string path)
+		/// <summary>
+		/// Returns the cache for <paramref name="root"/>, or null if we aren't using the cache. The index keeps track
+		/// of which files changed by itself, so the cache isn't used when indexing.
+		/// </summary>
+		private OutputCache? OpenCache(string root)
 		{
-			if (_options.OutputDisassembly == DisassemblyOutput.DisassemblyOnly)
+			if (!_options.UseCache || _index != null)
 			{
-				Logger.LogMessage($"Disassembling file: \"{path}\"");
+				return null;
 			}
-			else
+
+			var fullPath = Path.GetFullPath(root);
+
+			if (!_caches.TryGetValue(fullPath, out OutputCache? cache))
 			{
-				Logger.LogMessage($"Decompiling file: \"{path}\"");
+				cache = OutputCache.Load(fullPath);
+				_caches[fullPath] = cache;
 			}
 
+			return cache;
+		}
+
+		/// <param name="root">The directory that was passed in, or null if the file itself was passed in.</param>
+		private bool DecompileFile(string path, string? root, OutputCache? cache)
+		{
+			return DecompileFile(path, GetScriptPath(path, root), () => File.ReadAllBytes(path), cache, archive: null);
+		}
+
+		/// <param name="scriptPath">Where the script goes. The disassembly goes next to it.</param>
+		/// <param name="read">Reads the file, so that files don't have to come from the disk.</param>
+		/// <param name="archive">Where the output files go, or null to write them to the disk.</param>
+		private bool DecompileFile(string path, string scriptPath, Func<byte[]> read, OutputCache? cache, ArchiveOutput? archive)
+		{
+			var stats = _report != null ? new FileStatistics(path) : null;
+			var success = DecompileFile(path, scriptPath, read, cache, archive, stats);
+
+			if (!success)
+			{
+				_index?.Remove(path);
+			}
+
+			if (stats != null)
+			{
+				stats.Success = success;
+				_report!.Add(stats);
+			}
+
+			return success;
+		}
+
+		private bool DecompileFile(string path, string scriptPath, Func<byte[]> read, OutputCache? cache, ArchiveOutput? archive, FileStatistics? stats)
+		{
+			Logger.LogMessage($"{GetVerbs().Item2} file: \"{path}\"");
+
+			if (archive == null && FindOutputConflict(scriptPath, path) is string conflict)
+			{
+				Logger.LogError($"Output file \"{scriptPath}\" would overwrite the output of \"{conflict}\"");
+
+				return false;
+			}
+
+			// Checked before reading the file, since not having to read unchanged files is most of the point.
+			if (_index != null && archive == null && _index.IsUpToDate(path))
+			{
+				Logger.LogMessage("\tFile has not changed since it was last indexed, skipping", ConsoleColor.DarkGray);
+
+				if (stats != null)
+				{
+					stats.Cached = true;
+				}
+
+				return true;
+			}
+
+			byte[] bytes;
+			uint version;
+
+			try
+			{
+				bytes = FileStatistics.Measure(stats, Stage.Read, read);
+				version = FileLoader.ReadFileVersion(bytes);
+			}
+			catch (Exception exception)
+			{
+				Logger.LogError(exception.Message);
+
+				return false;
+			}
+
+			if (stats != null)
+			{
+				stats.FileSize = bytes.Length;
+			}
+
+			string? cacheKey = null;
+
+			if (cache != null)
+			{
+				cacheKey = OutputCache.CreateKey(bytes, _options);
+
+				if (cache.IsUpToDate(GetCachePath(path, scriptPath), cacheKey) && OutputFilesExist(scriptPath))
+				{
+					Logger.LogMessage("\tFile has not changed since it was last decompiled, skipping", ConsoleColor.DarkGray);
+
+					if (stats != null)
+					{
+						stats.Cached = true;
+					}
+
+					return true;
+				}
+			}
+
+			// Nothing from the file's AST is used after it's written, so its lists can go straight back to the pool.
+			var success = _arenas.Use(arena => DecompileFile(path, scriptPath, bytes, version, stats, archive, arena));
+
+			if (success && cacheKey != null)
+			{
+				cache!.Update(GetCachePath(path, scriptPath), cacheKey);
+			}
+
+			return success;
+		}
+
+		private bool DecompileFile(string path, string scriptPath, ReadOnlyMemory<byte> bytes, uint version, FileStatistics? stats, ArchiveOutput? archive, NodeListArena arena)
+		{
 			if (_options.GameIdentifier != GameIdentifier.Auto)
 			{
 				Logger.LogMessage($"\tUsing game settings: \"{GameVersion.GetDisplayName(_options.GameIdentifier)}\"", ConsoleColor.DarkGray);
 
-				return DecompileFile(path, _options.GameIdentifier, silentError: false);
+				return DecompileFile(path, scriptPath, bytes, _options.GameIdentifier, stats, archive, arena);
 			}
 
-			var version = FileLoader.ReadFileVersion(path);
 			var identifiers = GameVersion.GetIdentifiersFromVersion(version);
 
 			if (identifiers.Length <= 0)
@@ -164,122 +616,381 @@ namespace DSO
 			{
 				Logger.LogMessage($"\tGame automatically detected as {GameVersion.GetDisplayName(identifiers[0])}", ConsoleColor.DarkGray);
 
-				return DecompileFile(path, identifiers[0], silentError: false);
+				return DecompileFile(path, scriptPath, bytes, identifiers[0], stats, archive, arena);
 			}
 
 			Logger.LogWarning($"Multiple games use file version {version}!");
 
-			for (var i = 0; i < identifiers.Length; i++)
+			var (identifier, data) = FileStatistics.Measure(stats, Stage.Detect, () => DetectGame(bytes, identifiers));
+
+			Logger.LogMessage($"\tGame detected as {GameVersion.GetDisplayName(identifier)} (best match of {identifiers.Length})", ConsoleColor.DarkGray);
+
+			return DecompileFile(path, scriptPath, bytes, identifier, stats, archive, arena, data);
+		}
+
+		/// <summary>
+		/// Picks the game whose ops best fit the file's code stream (see <see cref="BytecodeReader.Score"/>). Games that
+		/// use the same file loader share one parse of the file, and the parsed data of the winner gets returned so it
+		/// doesn't have to be loaded again. Ties go to whichever game comes first.
+		/// </summary>
+		static private Tuple<GameIdentifier, FileData?> DetectGame(ReadOnlyMemory<byte> bytes, GameIdentifier[] identifiers)
+		{
+			var loaded = new Dictionary<Type, FileData?>();
+			var bestIdentifier = identifiers[0];
+			FileData? bestData = null;
+			var bestScore = int.MinValue;
+
+			foreach (var identifier in identifiers)
 			{
-				var ident = identifiers[i];
+				var loader = GameVersion.CreateFileLoader(identifier);
 
-				Logger.LogMessage($"\tAttempting with settings: \"{GameVersion.GetDisplayName(ident)}\"", ConsoleColor.DarkGray);
+				if (!loaded.TryGetValue(loader.GetType(), out FileData? data))
+				{
+					try
+					{
+						data = loader.LoadFile(bytes.Span);
+					}
+					catch (Exception)
+					{
+						// The file doesn't fit this game's layout at all.
+						data = null;
+					}
+
+					loaded[loader.GetType()] = data;
+				}
 
-				if (DecompileFile(path, ident, silentError: i < identifiers.Length - 1))
+				if (data == null)
 				{
-					return true;
+					continue;
 				}
-			}
 
-			Logger.LogError("Failed to decompile after multiple attempts");
+				var score = GameVersion.CreateBytecodeReader(identifier, data, GameVersion.GetOps(identifier)).Score();
 
-			return false;
+				if (score > bestScore)
+				{
+					bestIdentifier = identifier;
+					bestData = data;
+					bestScore = score;
+				}
+			}
+
+			return new(bestIdentifier, bestData);
 		}
 
-		private bool DecompileFile(string path, GameIdentifier identifier, bool silentError)
+		private bool DecompileFile(string path, string scriptPath, ReadOnlyMemory<byte> bytes, GameIdentifier identifier, FileStatistics? stats, ArchiveOutput? archive, NodeListArena arena, FileData? data = null)
 		{
-			GameVersion? game = null;
-			FileData data;
-			Disassembly disassembly;
+			GameVersion game;
+			Disassembly? disassembly = null;
 			List<Node> nodes = [];
 
 			var disassemblyOnly = _options.OutputDisassembly == DisassemblyOutput.DisassemblyOnly;
 
 			try
 			{
-				game = GameVersion.Create(identifier);
-				data = game?.FileLoader.LoadFile(path);
-
-				if (data.Version != game.Version)
+				// With nothing else to do with the instructions, they get written out as they're read instead.
+				if (disassemblyOnly && _index == null)
 				{
-					Logger.LogWarning($"File version {data.Version} differs from expected version {game.Version}");
+					(game, data) = Load(bytes, identifier, data, stats);
+				}
+				else
+				{
+					(game, data, disassembly, nodes) = Parse(bytes, identifier, data, build: !disassemblyOnly && _index == null, _options.ParallelFunctions, stats, arena: arena);
 				}
 
-				disassembly = new Disassembler.Disassembler().Disassemble(GameVersion.CreateBytecodeReader(identifier, data, game.Ops));
-
-				if (!disassemblyOnly)
+				if (_index != null)
 				{
-					nodes = new Builder().Build(new ControlFlowAnalyzer().Analyze(disassembly), disassembly);
+					_index.Update(path, identifier, disassembly!, fromDisk: archive == null);
+
+					return true;
 				}
 			}
 			catch (Exception exception)
 			{
-				if (!silentError)
-				{
-					Logger.LogError(exception.Message);
-				}
-
-				game.FileLoader?.Close();
+				Logger.LogError(exception.Message);
 
 				return false;
 			}
 
+			var success = true;
+
 			if (!disassemblyOnly)
 			{
-				var scriptPath = $"{Directory.GetParent(path)}/{Path.GetFileNameWithoutExtension(path)}";
+				Logger.LogMessage($"Writing output file: \"{archive?.GetDisplayPath(scriptPath) ?? scriptPath}\"");
 
-				Logger.LogMessage($"Writing output file: \"{scriptPath}\"");
-
-				WriteScriptFile(scriptPath, nodes);
+				success &= FileStatistics.Measure(stats, Stage.Generate, () => WriteScriptFile(scriptPath, nodes, archive));
 			}
 
 			if (_options.OutputDisassembly != DisassemblyOutput.None)
 			{
-				var disassemblyPath = $"{Directory.GetParent(path)}/{Path.GetFileNameWithoutExtension(path)}{DISASM_EXTENSION}";
+				var disassemblyPath = GetDisassemblyPath(scriptPath);
 
-				Logger.LogMessage($"Writing disassembly file: \"{disassemblyPath}\"");
+				Logger.LogMessage($"Writing disassembly file: \"{archive?.GetDisplayPath(disassemblyPath) ?? disassemblyPath}\"");
 
-				WriteDisassemblyFile(disassemblyPath, game, data, disassembly);
+				success &= FileStatistics.Measure(stats, Stage.WriteDisassembly, () => WriteDisassemblyFile(disassemblyPath, game, identifier, data, disassembly, stats, archive));
 			}
 
-			return true;
+			return success;
 		}
 
-		private bool WriteScriptFile(string outputPath, List<Node> nodes)
+		/// <summary>
+		/// Everything from loading the file to building the AST, without touching the disk or the log. Warnings go in
+		/// <paramref name="warnings"/> if it's passed in, and get logged otherwise. The AST is only good until
+		/// <paramref name="arena"/> is reset.
+		/// </summary>
+		private Tuple<GameVersion, FileData, Disassembly, List<Node>> Parse(ReadOnlyMemory<byte> bytes, GameIdentifier identifier,
+			FileData? data, bool build, bool parallelFunctions, FileStatistics? stats, List<string>? warnings = null, NodeListArena? arena = null)
 		{
-			var success = false;
+			var (game, fileData) = Load(bytes, identifier, data, stats, warnings);
+			var reader = GameVersion.CreateBytecodeReader(identifier, fileData, game.Ops!)!;
+			var disassembly = FileStatistics.Measure(stats, Stage.Disassemble, () => new Disassembler.Disassembler().Disassemble(reader));
+			List<Node> nodes = [];
+
+			if (build)
+			{
+				var controlFlow = FileStatistics.Measure(stats, Stage.ControlFlow, () => new ControlFlowAnalyzer().Analyze(disassembly));
+
+				nodes = FileStatistics.Measure(stats, Stage.Build, () => parallelFunctions
+					? new ParallelBuilder(Environment.ProcessorCount, _builders).Build(controlFlow, disassembly, arena)
+					: _builders.Use(builder => builder.Build(controlFlow, disassembly, arena: arena)), allThreads: parallelFunctions);
+			}
+
+			if (stats != null)
+			{
+				stats.Instructions = disassembly.Count;
+				stats.TopLevelNodes = nodes.Count;
+				stats.Nodes = Node.CountNodes(nodes);
+			}
+
+			return new(game, fileData, disassembly, nodes);
+		}
+
+		/// <summary>
+		/// Loads the file and checks its version, which is all that's needed before its disassembly can be written.
+		/// </summary>
+		private Tuple<GameVersion, FileData> Load(ReadOnlyMemory<byte> bytes, GameIdentifier identifier, FileData? data,
+			FileStatistics? stats, List<string>? warnings = null)
+		{
+			var game = GameVersion.Create(identifier) ?? throw new DecompilerException($"Invalid game: {identifier}");
 
 			try
 			{
-				File.WriteAllText(outputPath, string.Join("", new CodeGenerator.CodeGenerator().Generate(nodes)));
-				success = true;
+				data ??= FileStatistics.Measure(stats, Stage.Load, () => game.FileLoader!.LoadFile(bytes.Span));
+			}
+			finally
+			{
+				game.FileLoader?.Close();
+			}
+
+			if (stats != null)
+			{
+				stats.Game = identifier;
+				stats.Record(data);
+			}
+
+			if (data.Version != game.Version)
+			{
+				var warning = $"File version {data.Version} differs from expected version {game.Version}";
+
+				if (warnings != null)
+				{
+					warnings.Add(warning);
+				}
+				else
+				{
+					Logger.LogWarning(warning);
+				}
+			}
+
+			return new(game, data);
+		}
+
+		/// <summary>
+		/// Output files go next to the file, or in the same place under <see cref="CommandLineOptions.OutputPath"/>
+		/// as the file is under <paramref name="root"/> if there is one.
+		/// </summary>
+		private string GetScriptPath(string path, string? root)
+		{
+			if (_options.OutputPath == null)
+			{
+				return $"{Directory.GetParent(path)}/{Path.GetFileNameWithoutExtension(path)}";
+			}
+
+			var relativePath = root == null ? Path.GetFileName(path) : Path.GetRelativePath(root, path);
+
+			return Path.Join(_options.OutputPath, Path.GetDirectoryName(relativePath), Path.GetFileNameWithoutExtension(relativePath));
+		}
+
+		/// <summary>
+		/// With <see cref="CommandLineOptions.OutputPath"/>, files from different paths that were passed in can end
+		/// up with the same output path (like <c>a/main.cs.dso</c> and <c>b/main.cs.dso</c>). The first file gets to
+		/// keep it, and this returns that file for any other file that tries to use it, so it fails instead of
+		/// overwriting the output.
+		/// </summary>
+		private string? FindOutputConflict(string outputPath, string path)
+		{
+			if (_options.OutputPath == null || _index != null)
+			{
+				return null;
+			}
+
+			var owner = _outputPaths.GetOrAdd(Path.GetFullPath(outputPath), path);
+
+			return Path.GetFullPath(owner) == Path.GetFullPath(path) ? null : owner;
+		}
+
+		static private string GetDisassemblyPath(string scriptPath) => $"{scriptPath}{DISASM_EXTENSION}";
+
+		/// <summary>
+		/// When there's an output directory, the cache lives there (since the files might be somewhere we can't
+		/// write to), so it keeps track of the output files instead of the files that were passed in.
+		/// </summary>
+		private string GetCachePath(string path, string scriptPath) => _options.OutputPath != null ? scriptPath : path;
+
+		private bool OutputFilesExist(string scriptPath)
+		{
+			return (_options.OutputDisassembly == DisassemblyOutput.DisassemblyOnly || File.Exists(scriptPath))
+				&& (_options.OutputDisassembly == DisassemblyOutput.None || File.Exists(GetDisassemblyPath(scriptPath)));
+		}
+
+		/// <summary>
+		/// Creates every directory the output files go in ahead of time, so each directory is only created once
+		/// instead of once per file.
+		/// </summary>
+		private bool CreateOutputDirectories(IEnumerable<string> scriptPaths)
+		{
+			if (_options.OutputPath == null || _index != null)
+			{
+				return true;
+			}
+
+			try
+			{
+				foreach (var directory in scriptPaths.Select(Path.GetDirectoryName).Distinct())
+				{
+					if (!string.IsNullOrEmpty(directory))
+					{
+						Directory.CreateDirectory(directory);
+					}
+				}
 			}
 			catch (Exception exception)
 			{
 				Logger.LogError(exception.Message);
+
+				return false;
 			}
 
-			return success;
+			return true;
 		}
 
-		private bool WriteDisassemblyFile(string outputPath, GameVersion game, FileData fileData, Disassembly disassembly)
+		private void WriteIndex(string outputPath)
 		{
-			var success = false;
+			Logger.LogMessage($"Writing index file: \"{outputPath}\"");
 
 			try
 			{
-				var writer = new DisassemblyWriter();
+				_index!.Save();
+			}
+			catch (Exception exception)
+			{
+				Logger.LogError(exception.Message);
+			}
+		}
 
-				writer.WriteHeader(game, fileData);
+		private void WriteStatistics(string outputPath, long totalTime)
+		{
+			Logger.LogMessage($"Writing statistics file: \"{outputPath}\"");
+
+			try
+			{
+				_report!.Write(outputPath, totalTime);
+			}
+			catch (Exception exception)
+			{
+				Logger.LogError(exception.Message);
+			}
+		}
+
+		private bool WriteScriptFile(string outputPath, List<Node> nodes, ArchiveOutput? archive) => WriteOutputFile(outputPath,
+			writer => new CodeGenerator.CodeGenerator().Generate(nodes, writer), archive);
+
+		/// <summary>
+		/// If there's no <paramref name="disassembly"/>, the file is disassembled as it's written, so the time spent
+		/// disassembling it counts as writing instead.
+		/// </summary>
+		private bool WriteDisassemblyFile(string outputPath, GameVersion game, GameIdentifier identifier, FileData fileData,
+			Disassembly? disassembly, FileStatistics? stats, ArchiveOutput? archive) => WriteOutputFile(outputPath, output =>
+		{
+			var writer = new DisassemblyWriter(output);
+
+			writer.WriteHeader(game, fileData);
+
+			if (disassembly != null)
+			{
 				disassembly.Visit(writer);
 
-				File.WriteAllText(outputPath, string.Join("", writer.Stream));
+				return;
+			}
+
+			var reader = GameVersion.CreateBytecodeReader(identifier, fileData, game.Ops!)!;
+			var count = new Disassembler.Disassembler().Disassemble(reader, writer);
+
+			if (stats != null)
+			{
+				stats.Instructions = count;
+			}
+		}, archive);
+
+		/// <summary>
+		/// Streams output straight to disk through a buffered writer instead of building the whole file in memory.<br/><br/>
+		///
+		/// The output goes to a temporary file that only replaces the real one once it's finished, so a failed or
+		/// interrupted write never leaves a partial file behind.
+		/// </summary>
+		private bool WriteOutputFile(string outputPath, Action<TextWriter> write, ArchiveOutput? archive)
+		{
+			if (archive != null)
+			{
+				try
+				{
+					archive.Write(outputPath, write);
+
+					return true;
+				}
+				catch (Exception exception)
+				{
+					Logger.LogError(exception.Message);
+
+					return false;
+				}
+			}
+
+			var success = false;
+			var tempPath = $"{outputPath}{TEMP_EXTENSION}";
+
+			try
+			{
+				using (var writer = new StreamWriter(tempPath, append: false, _encoding, OUTPUT_BUFFER_SIZE))
+				{
+					write(writer);
+				}
+
+				File.Move(tempPath, outputPath, overwrite: true);
 
 				success = true;
 			}
 			catch (Exception exception)
 			{
 				Logger.LogError(exception.Message);
+
+				try
+				{
+					File.Delete(tempPath);
+				}
+				catch (Exception)
+				{
+					// We already logged the error that matters.
+				}
 			}
 
 			return success;
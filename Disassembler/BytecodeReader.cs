@@ -136,6 +136,195 @@ namespace DSO.Disassembler
 			};
 		}
 
+		/// <summary>
+		/// Returns how many operands follow the op at <paramref name="address"/> without actually reading them, or
+		/// <see langword="null"/> if it can't be determined.
+		/// </summary>
+		protected virtual uint? GetOperandCount(OpcodeTag tag, uint address) => tag switch
+		{
+			// Name, namespace, package, has body, end address, argument count, and then the arguments.
+			OpcodeTag.OP_FUNC_DECL => address + 6 < _data.Code.Length ? 6 + _data.Code[address + 6] : null,
+
+			OpcodeTag.OP_CREATE_OBJECT => 3,
+			OpcodeTag.OP_CALLFUNC or OpcodeTag.OP_CALLFUNC_RESOLVE => 3,
+
+			OpcodeTag.OP_ADD_OBJECT or OpcodeTag.OP_END_OBJECT or
+			OpcodeTag.OP_JMP or
+			OpcodeTag.OP_JMPIF_NP or OpcodeTag.OP_JMPIFNOT_NP or
+			OpcodeTag.OP_JMPIF or OpcodeTag.OP_JMPIFF or
+			OpcodeTag.OP_JMPIFNOT or OpcodeTag.OP_JMPIFFNOT or
+			OpcodeTag.OP_SETCURVAR or OpcodeTag.OP_SETCURVAR_CREATE or
+			OpcodeTag.OP_SETCURFIELD or
+			OpcodeTag.OP_LOADIMMED_UINT or OpcodeTag.OP_LOADIMMED_FLT or
+			OpcodeTag.OP_TAG_TO_STR or OpcodeTag.OP_LOADIMMED_STR or OpcodeTag.OP_LOADIMMED_IDENT or
+			OpcodeTag.OP_ADVANCE_STR_APPENDCHAR => 1,
+
+			OpcodeTag.OP_INVALID => null,
+
+			_ => 0,
+		};
+
+		/// <summary>
+		/// Finds where every instruction starts and where every branch goes, in one pass over the code stream that
+		/// doesn't create any instructions (same as <see cref="Score"/>). Stops at the first op that can't be decoded.
+		/// </summary>
+		public InstructionStream Scan()
+		{
+			var code = _data.Code;
+			var stream = new InstructionStream(code.Length);
+
+			uint address = 0;
+
+			while (address < code.Length)
+			{
+				var opcode = _ops.GetOpcode(code[address]);
+				var operands = opcode == null ? null : GetOperandCount(opcode.Tag, address);
+
+				if (opcode == null || operands == null || address + operands >= code.Length)
+				{
+					break;
+				}
+
+				stream.Add(opcode.Tag, address, operands.Value);
+
+				if (opcode.Tag is OpcodeTag.OP_JMP or
+					OpcodeTag.OP_JMPIF_NP or OpcodeTag.OP_JMPIFNOT_NP or
+					OpcodeTag.OP_JMPIF or OpcodeTag.OP_JMPIFF or
+					OpcodeTag.OP_JMPIFNOT or OpcodeTag.OP_JMPIFFNOT)
+				{
+					stream.AddBranchTarget(code[address + 1]);
+				}
+
+				address += 1 + operands.Value;
+			}
+
+			return stream;
+		}
+
+		/// <summary>
+		/// Makes one quick pass over the code stream without creating any instructions, to see how well it fits
+		/// these ops. Every op has to be valid, and operands have to look sane: table indices have to exist, names
+		/// have to be identifiers, and branches have to land on instructions inside the same function.<br/><br/>
+		///
+		/// Returns the number of instructions that passed. The pass stops at the first op that can't be decoded.
+		/// </summary>
+		public int Score()
+		{
+			var code = _data.Code;
+			var starts = new bool[code.Length];
+			var branchTargets = new List<uint>();
+
+			uint address = 0;
+			uint functionStart = 0;
+			uint functionEnd = 0;
+
+			var inFunction = false;
+			var score = 0;
+
+			while (address < code.Length)
+			{
+				var opcode = _ops.GetOpcode(code[address]);
+				var operands = opcode == null ? null : GetOperandCount(opcode.Tag, address);
+
+				if (opcode == null || operands == null || address + operands >= code.Length)
+				{
+					break;
+				}
+
+				if (inFunction && address >= functionEnd)
+				{
+					inFunction = false;
+				}
+
+				var valid = true;
+				var floats = inFunction ? _data.FunctionFloatTable : _data.GlobalFloatTable;
+				var strings = inFunction ? _data.FunctionStringTable : _data.GlobalStringTable;
+
+				bool IsIdentifier(uint offset) => _data.IdentifierTable.ContainsKey(address + offset);
+				bool IsBool(uint offset) => code[address + offset] <= 1;
+
+				switch (opcode.Tag)
+				{
+					case OpcodeTag.OP_FUNC_DECL:
+					{
+						var hasBody = code[address + 4];
+						var end = code[address + 5];
+
+						valid = IsIdentifier(1) && IsBool(4) && (hasBody == 0 || (end > address && end < code.Length));
+
+						if (valid && hasBody != 0)
+						{
+							inFunction = true;
+							functionStart = address;
+							functionEnd = end;
+						}
+
+						break;
+					}
+
+					case OpcodeTag.OP_JMP or
+						OpcodeTag.OP_JMPIF_NP or OpcodeTag.OP_JMPIFNOT_NP or
+						OpcodeTag.OP_JMPIF or OpcodeTag.OP_JMPIFF or
+						OpcodeTag.OP_JMPIFNOT or OpcodeTag.OP_JMPIFFNOT:
+					{
+						var target = code[address + 1];
+
+						valid = target < code.Length && (!inFunction || (target > functionStart && target < functionEnd));
+
+						if (valid)
+						{
+							branchTargets.Add(target);
+						}
+
+						break;
+					}
+
+					case OpcodeTag.OP_ADD_OBJECT or OpcodeTag.OP_END_OBJECT:
+						valid = IsBool(1);
+						break;
+
+					case OpcodeTag.OP_SETCURVAR or OpcodeTag.OP_SETCURVAR_CREATE or
+						OpcodeTag.OP_SETCURFIELD or OpcodeTag.OP_LOADIMMED_IDENT:
+						valid = IsIdentifier(1);
+						break;
+
+					case OpcodeTag.OP_CALLFUNC or OpcodeTag.OP_CALLFUNC_RESOLVE:
+						valid = IsIdentifier(1) && code[address + 3] < 3;
+						break;
+
+					case OpcodeTag.OP_LOADIMMED_FLT:
+						valid = code[address + 1] < floats.Count;
+						break;
+
+					case OpcodeTag.OP_TAG_TO_STR or OpcodeTag.OP_LOADIMMED_STR:
+						valid = code[address + 1] < strings.Size;
+						break;
+
+					default:
+						break;
+				}
+
+				if (valid)
+				{
+					score++;
+				}
+
+				starts[address] = true;
+				address += 1 + operands.Value;
+			}
+
+			// Branches into the middle of an instruction are a pretty good sign that these are the wrong ops.
+			foreach (var target in branchTargets)
+			{
+				if (!starts[target])
+				{
+					score--;
+				}
+			}
+
+			return score;
+		}
+
 		public uint ReadUInt() => _data.Code[_index++];
 		public bool ReadBool() => ReadUInt() != 0;
 		public char ReadChar() => (char) ReadUInt();
@@ -31,16 +31,47 @@ namespace DSO.Disassembler
 			return Disassemble();
 		}
 
+		/// <summary>
+		/// Writes the disassembly out as each instruction is decoded, instead of building a whole
+		/// <see cref="Disassembly"/> first. Nothing is kept after it's written, and branch labels come from
+		/// <see cref="BytecodeReader.Scan"/>, since a label has to be written before anything jumps to it.
+		/// </summary>
+		/// <returns>How many instructions were written.</returns>
+		public int Disassemble(BytecodeReader reader, DisassemblyWriter writer)
+		{
+			var stream = reader.Scan();
+			var count = 0;
+
+			_reader = reader;
+
+			while (!_reader.IsAtEnd)
+			{
+				var instruction = _reader.ReadInstruction();
+
+				ValidateInstruction(instruction);
+
+				if (stream.IsBranchTarget(instruction.Address))
+				{
+					writer.WriteBranchLabel(instruction.Address);
+				}
+
+				writer.Write(instruction);
+				count++;
+			}
+
+			return count;
+		}
+
 		private Disassembly Disassemble()
 		{
-			var disassembly = new Disassembly();
+			var disassembly = new Disassembly(_reader.CodeSize);
 
 			while (!_reader.IsAtEnd)
 			{
 				var instruction = _reader.ReadInstruction();
 
 				ValidateInstruction(instruction);
-				disassembly.AddInstruction(instruction);
+				disassembly.AddInstruction(instruction, operandCount: _reader.Index - instruction.Address - 1);
 			}
 
 			return disassembly;
@@ -15,17 +15,25 @@ namespace DSO.Disassembler
 	public class Disassembly : IEnumerable<Instruction>
 	{
 		private readonly List<Instruction> _list = [];
-		private readonly Dictionary<uint, Instruction> _dictionary = [];
+
+		/// <summary>
+		/// Flat opcode tags, addresses, and operand info for each instruction, in the same order as <see cref="_list"/>.
+		/// It's kept in addition to the instructions, not instead of them.
+		/// </summary>
+		public readonly InstructionStream Stream;
 
 		public int Count => _list.Count;
 
 		public Instruction? First => _list.Count > 0 ? _list[0] : null;
 		public Instruction? Last => _list.Count > 0 ? _list[^1] : null;
 
+		public Instruction this[int index] => _list[index];
+
 		public readonly List<BranchInstruction> Branches = [];
-		private readonly HashSet<uint> _branchTargets = [];
 
-		public Instruction AddInstruction(Instruction instruction)
+		public Disassembly(int codeSize) => Stream = new(codeSize);
+
+		public Instruction AddInstruction(Instruction instruction, uint operandCount = 0)
 		{
 			var last = Last;
 
@@ -38,46 +46,46 @@ namespace DSO.Disassembler
 			if (instruction is BranchInstruction branch)
 			{
 				Branches.Add(branch);
-				_branchTargets.Add(branch.TargetAddress);
+				Stream.AddBranchTarget(branch.TargetAddress);
 			}
 
 			_list.Add(instruction);
-			_dictionary[instruction.Address] = instruction;
+			Stream.Add(instruction.Opcode.Tag, instruction.Address, operandCount);
 
 			return instruction;
 		}
 
-		public bool HasInstruction(uint address) => _dictionary.ContainsKey(address);
-		public Instruction? GetInstruction(uint address) => HasInstruction(address) ? _dictionary[address] : null;
+		public bool HasInstruction(uint address) => Stream.HasInstruction(address);
+		public Instruction? GetInstruction(uint address) => Stream.IndexOf(address) is int index && index >= 0 ? _list[index] : null;
 		public List<Instruction> GetInstructions() => [.._list];
 
 		public List<Instruction> SliceInstructions(uint fromAddress, uint toAddress)
 		{
 			var slice = new List<Instruction>();
+			var index = Stream.IndexOf(fromAddress);
 
-			for (var instruction = _dictionary[fromAddress]; instruction != null && instruction.Address <= toAddress; instruction = instruction.Next)
+			if (index < 0)
 			{
-				slice.Add(instruction);
+				throw new KeyNotFoundException($"No instruction at {fromAddress}");
 			}
 
-			return slice;
-		}
-
-		public IEnumerator<Instruction> GetEnumerator()
-		{
-			for (var instruction = First; instruction != null; instruction = instruction.Next)
+			for (; index < _list.Count && _list[index].Address <= toAddress; index++)
 			{
-				yield return instruction;
+				slice.Add(_list[index]);
 			}
+
+			return slice;
 		}
 
+		public IEnumerator<Instruction> GetEnumerator() => _list.GetEnumerator();
+
 		IEnumerator IEnumerable.GetEnumerator() => GetEnumerator();
 
 		public void Visit(DisassemblyWriter writer)
 		{
 			foreach (var instruction in _list)
 			{
-				if (_branchTargets.Contains(instruction.Address))
+				if (Stream.IsBranchTarget(instruction.Address))
 				{
 					writer.WriteBranchLabel(instruction.Address);
 				}
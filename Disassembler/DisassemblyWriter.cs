@@ -9,15 +9,32 @@
  */
 
 using DSO.Loader;
+using DSO.Opcodes;
 using DSO.Versions;
 using static DSO.Constants.Decompiler;
 using static DSO.Constants.Disassembler;
 
 namespace DSO.Disassembler
 {
-	public class DisassemblyWriter
+	/// <summary>
+	/// Writes disassembly text straight to a <see cref="TextWriter"/>.<br/><br/>
+	///
+	/// There's a line for every single value in the code stream, so lines are written a piece at a time instead of
+	/// being formatted into strings first. Disassembling a big file is mostly spent in here otherwise.
+	/// </summary>
+	public class DisassemblyWriter(TextWriter writer)
 	{
-		public List<string> Stream { get; set; } = [];
+		private const string INDENT = "        ";
+		private const string COMMENT_SEPARATOR = "    ; ";
+
+		static private readonly string _padding = new(' ', VALUE_COLUMN_LENGTH);
+
+		static private readonly Dictionary<OpcodeTag, string> _tagNames = Enum.GetValues<OpcodeTag>()
+			.Distinct()
+			.ToDictionary(tag => tag, tag => tag.ToString());
+
+		private readonly TextWriter _writer = writer;
+
 		public uint Address { get; set; } = 0;
 		public FunctionInstruction? Function { get; set; } = null;
 
@@ -36,11 +53,13 @@ namespace DSO.Disassembler
 			Write("\n");
 		}
 
+		public void Write(string token) => _writer.Write(token);
+
 		public void Write(params string[] tokens)
 		{
 			foreach (var token in tokens)
 			{
-				Stream.Add(token);
+				_writer.Write(token);
 			}
 		}
 
@@ -74,73 +93,195 @@ namespace DSO.Disassembler
 			instruction.Visit(this);
 		}
 
-		public void WriteValue(object token, string comment = "", bool indent = true)
+		public void WriteValue(OpcodeTag tag, string comment = "", bool indent = true)
 		{
-			if (token is StringTableEntry entry)
+			WriteLine(Address++, _tagNames.TryGetValue(tag, out string? name) ? name : tag.ToString(), comment, indent);
+		}
+
+		public void WriteValue<T>(T token, string comment = "", bool indent = true)
+		{
+			switch (token)
 			{
-				var str = Util.String.EscapeString(entry.Value);
+				case StringTableEntry entry:
+					WriteStringTableEntry(entry, comment, indent);
+					return;
 
-				if (str.Length > VALUE_TRUNCATE_LENGTH)
-				{
-					str = $"\"{str[..VALUE_TRUNCATE_LENGTH]}\" <...>";
-					comment += " (truncated)";
-				}
-				else
+				case string str:
+					WriteLine(Address++, str, comment, indent);
+					return;
+
+				case char ch:
+					WriteLine(Address++, $"'{Util.String.EscapeChar(ch)}'", comment, indent);
+					return;
+
+				case bool value:
+					WriteLine(Address++, value ? "(true)" : "(false)", comment, indent);
+					return;
+
+				case null:
+					WriteLine(Address++, "(null)", comment, indent);
+					return;
+
+				case ISpanFormattable formattable:
 				{
-					str = $"\"{str}\"";
-				}
+					Span<char> buffer = stackalloc char[64];
 
-				comment += $" ({(entry.Global ? "global" : "function")} table index: {entry.Index})";
-				token = str;
-			}
+					if (formattable.TryFormat(buffer, out int length, default, null))
+					{
+						WriteLine(Address++, buffer[..length], comment, indent);
+						return;
+					}
 
-			var stringToken = token switch
-			{
-				string str => str,
-				char ch => $"'{Util.String.EscapeChar(ch)}'",
-				bool => $"({token.ToString().ToLower()})",
-				null => "(null)",
-				_ => token.ToString(),
-			};
+					break;
+				}
+			}
 
-			WriteLine(Address++, stringToken, comment, indent);
+			WriteLine(Address++, token.ToString(), comment, indent);
 		}
 
 		public void WriteBranchLabel(uint target)
 		{
+			Span<char> label = stackalloc char[15];
+
+			" addr_".CopyTo(label);
+			target.TryFormat(label[6..], out _, "x8");
+			label[^1] = ':';
+
 			WriteLine(Address, "", "", indent: false);
-			WriteLine(Address, $" addr_{target:x8}:", "", indent: false);
+			WriteLine(Address, label, "", indent: false);
+		}
+
+		public void WriteBranchTarget(uint target, string comment = "")
+		{
+			Span<char> token = stackalloc char[15];
+
+			"[addr_".CopyTo(token);
+			target.TryFormat(token[6..], out _, "x8");
+			token[^1] = ']';
+
+			WriteLine(Address++, token, comment);
+		}
+
+		public void WriteAddressValue(uint address, string comment = "")
+		{
+			Span<char> token = stackalloc char[10];
+
+			"0x".CopyTo(token);
+			address.TryFormat(token[2..], out _, "X8");
+
+			WriteLine(Address++, token, comment);
 		}
 
-		public void WriteBranchTarget(uint target, string comment = "") => WriteLine(Address++, $"[addr_{target:x8}]", comment);
-		public void WriteAddressValue(uint address, string comment = "") => WriteLine(Address++, $"0x{address:X8}", comment);
 		public void WriteCommentLine(string comment, bool writeAddress = false, bool indent = false)
 		{
 			if (writeAddress)
 			{
-				Write(string.Format("{0,-8:X8}", Address));
+				WriteAddress(Address);
 			}
 
-			Write(string.Format("{0}; {1}\n", indent ? "        " : (writeAddress ? " " : ""), comment));
+			_writer.Write(indent ? INDENT : (writeAddress ? " " : ""));
+			_writer.Write("; ");
+			_writer.Write(comment);
+			_writer.Write('\n');
 		}
 
 		public void WriteLine(uint address, string token = "", string comment = "", bool indent = true)
 		{
-			if (token == "")
+			WriteLine(address, token.AsSpan(), comment, indent);
+		}
+
+		private void WriteLine(uint address, ReadOnlySpan<char> token, string comment = "", bool indent = true)
+		{
+			WriteLineStart(address, indent);
+
+			if (!token.IsEmpty)
+			{
+				_writer.Write(token);
+				WritePadding(token.Length);
+			}
+
+			if (comment != "")
+			{
+				_writer.Write(COMMENT_SEPARATOR);
+				_writer.Write(comment);
+			}
+
+			_writer.Write('\n');
+		}
+
+		/// <summary>
+		/// Strings get quoted and escaped, and long ones get cut off. The comment says which table the string is from.
+		/// </summary>
+		private void WriteStringTableEntry(StringTableEntry entry, string comment, bool indent)
+		{
+			var str = Util.String.EscapeString(entry.Value);
+			var truncated = str.Length > VALUE_TRUNCATE_LENGTH;
+
+			WriteLineStart(Address++, indent);
+
+			_writer.Write('"');
+
+			if (truncated)
 			{
-				Write(string.Format($"{{0,-8:X8}}{{1}}", address, indent ? "        " : ""));
+				_writer.Write(str.AsSpan(0, VALUE_TRUNCATE_LENGTH));
+				_writer.Write("\" <...>");
+				WritePadding(VALUE_TRUNCATE_LENGTH + 8);
 			}
 			else
 			{
-				Write(string.Format($"{{0,-8:X8}}{{1}}{{2,-{VALUE_COLUMN_LENGTH}}}", address, indent ? "        " : "", token));
+				_writer.Write(str);
+				_writer.Write('"');
+				WritePadding(str.Length + 2);
 			}
 
-			if (comment != "")
+			_writer.Write(COMMENT_SEPARATOR);
+			_writer.Write(comment);
+
+			if (truncated)
 			{
-				Write($"    ; {comment}");
+				_writer.Write(" (truncated)");
 			}
 
-			Write("\n");
+			_writer.Write(entry.Global ? " (global table index: " : " (function table index: ");
+			WriteNumber(entry.Index);
+			_writer.Write(")\n");
+		}
+
+		private void WriteLineStart(uint address, bool indent)
+		{
+			WriteAddress(address);
+
+			if (indent)
+			{
+				_writer.Write(INDENT);
+			}
+		}
+
+		private void WriteAddress(uint address)
+		{
+			Span<char> buffer = stackalloc char[8];
+
+			address.TryFormat(buffer, out _, "X8");
+			_writer.Write(buffer);
+		}
+
+		private void WriteNumber(uint number)
+		{
+			Span<char> buffer = stackalloc char[10];
+
+			number.TryFormat(buffer, out int length);
+			_writer.Write(buffer[..length]);
+		}
+
+		/// <summary>
+		/// Pads a token that's <paramref name="length"/> characters long out to the comment column.
+		/// </summary>
+		private void WritePadding(int length)
+		{
+			if (length < VALUE_COLUMN_LENGTH)
+			{
+				_writer.Write(_padding.AsSpan(0, VALUE_COLUMN_LENGTH - length));
+			}
 		}
 	}
 }
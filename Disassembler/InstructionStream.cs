@@ -0,0 +1,108 @@
+﻿/**
+ * InstructionStream.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.Opcodes;
+
+namespace DSO.Disassembler
+{
+	/// <summary>
+	/// A compact, flat index of a disassembly. Every instruction is just an entry in a few parallel arrays, and
+	/// there's a flat map from code address to instruction index, so address lookups, the control flow graph, and
+	/// branch labels don't have to chase <see cref="Instruction"/> objects around.<br/><br/>
+	///
+	/// This sits next to the <see cref="Instruction"/> objects rather than replacing them, so it doesn't save any
+	/// allocations when decompiling. Only <see cref="BytecodeReader.Scan"/> fills one without creating instructions.
+	/// </summary>
+	public class InstructionStream
+	{
+		private OpcodeTag[] _tags = [];
+		private uint[] _addresses = [];
+		private uint[] _operandCounts = [];
+
+		/// <summary>
+		/// Maps code addresses to instruction indices. Addresses that are operands (or past the end) map to -1.
+		/// </summary>
+		private int[] _indices = [];
+
+		/// <summary>
+		/// Only covers the code itself, since a jump to anywhere else can't land on an instruction.
+		/// </summary>
+		private readonly bool[] _branchTargets;
+
+		public int Count { get; private set; } = 0;
+
+		public InstructionStream(int codeSize)
+		{
+			_branchTargets = new bool[codeSize];
+
+			EnsureCodeSize(codeSize);
+		}
+
+		public OpcodeTag GetTag(int index) => _tags[index];
+		public uint GetAddress(int index) => _addresses[index];
+		public uint GetOperandCount(int index) => _operandCounts[index];
+
+		/// <summary>
+		/// Operands always directly follow their opcode, so this is just here for readability.
+		/// </summary>
+		public uint GetOperandOffset(int index) => _addresses[index] + 1;
+
+		public int IndexOf(uint address) => address < _indices.Length ? _indices[address] : -1;
+		public bool HasInstruction(uint address) => IndexOf(address) >= 0;
+		public bool IsBranchTarget(uint address) => address < _branchTargets.Length && _branchTargets[address];
+
+		public int Add(OpcodeTag tag, uint address, uint operandCount)
+		{
+			if (Count >= _tags.Length)
+			{
+				var capacity = Math.Max(Count * 2, 16);
+
+				Array.Resize(ref _tags, capacity);
+				Array.Resize(ref _addresses, capacity);
+				Array.Resize(ref _operandCounts, capacity);
+			}
+
+			EnsureCodeSize(address + operandCount + 1);
+
+			_tags[Count] = tag;
+			_addresses[Count] = address;
+			_operandCounts[Count] = operandCount;
+			_indices[address] = Count;
+
+			return Count++;
+		}
+
+		/// <summary>
+		/// Branch targets come straight from the file, so ones that are outside the code are ignored instead of
+		/// deciding how much memory we allocate.
+		/// </summary>
+		public void AddBranchTarget(uint target)
+		{
+			if (target < _branchTargets.Length)
+			{
+				_branchTargets[target] = true;
+			}
+		}
+
+		private void EnsureCodeSize(long size)
+		{
+			if (size <= _indices.Length)
+			{
+				return;
+			}
+
+			var oldSize = _indices.Length;
+			var newSize = (int) Math.Max(size, oldSize * 2L);
+
+			Array.Resize(ref _indices, newSize);
+			Array.Fill(_indices, -1, oldSize, newSize - oldSize);
+		}
+	}
+}
@@ -28,68 +28,109 @@ namespace DSO.Loader
 		public override string ToString() => Value;
 	}
 
+	/// <summary>
+	/// All the strings in a table are stored back-to-back in <see cref="RawString"/>, each followed by a null
+	/// terminator. Rather than splitting it up, we keep the positions of the terminators, which lets us find the
+	/// string at any index (even one in the middle of another string) with a binary search.<br/><br/>
+	///
+	/// Entries are only created the first time they're looked up.
+	/// </summary>
 	public class StringTable()
 	{
-		private readonly Dictionary<uint, StringTableEntry> _table = [];
+		/// <summary>
+		/// The index of every null terminator in <see cref="RawString"/>, in ascending order.
+		/// </summary>
+		private readonly int[] _terminators = [];
+
+		/// <summary>
+		/// Entries that start right after a terminator, indexed the same as <see cref="_terminators"/>.
+		/// </summary>
+		private readonly StringTableEntry?[] _entries = [];
+
+		/// <summary>
+		/// Entries that start in the middle of another string.
+		/// </summary>
+		private readonly Dictionary<uint, StringTableEntry> _substrings = [];
 
 		public string RawString { get; private set; } = "";
 		public readonly bool Global;
 
-		public int Count => _table.Count;
+		public int Count => _terminators.Length;
 		public int Size => RawString.Length;
 
 		public StringTableEntry this[uint index] => Get(index);
 
 		public StringTable(string rawStr, bool global) : this()
 		{
-			_table = [];
 			RawString = rawStr;
 			Global = global;
 
-			uint index = 0;
-			string str = "";
+			var span = RawString.AsSpan();
 
-			var length = RawString.Length;
+			_terminators = new int[span.Count('\0')];
+			_entries = new StringTableEntry?[_terminators.Length];
 
-			for (int i = 0; i < length; i++)
+			for (int i = 0, offset = 0; i < _terminators.Length; i++)
 			{
-				var ch = RawString[i];
-
-				if (ch == '\0')
-				{
-					_table[index] = new(str, index, global);
-
-					str = "";
-					index = (uint) i + 1;
-				}
-				else
-				{
-					str += ch;
-				}
+				offset += span[offset..].IndexOf('\0');
+				_terminators[i] = offset++;
 			}
 		}
 
 		public StringTableEntry? Get(uint index)
 		{
-			if (Has(index))
+			if (index >= RawString.Length)
+			{
+				return null;
+			}
+
+			var terminator = FindTerminator(index);
+
+			if (terminator < Count && index == GetStartIndex(terminator))
+			{
+				return _entries[terminator] ??= CreateEntry(index, terminator);
+			}
+
+			if (!_substrings.TryGetValue(index, out StringTableEntry? entry))
 			{
-				return _table[index];
+				entry = CreateEntry(index, terminator);
+				_substrings[index] = entry;
 			}
 
+			return entry;
+		}
+
+		public bool Has(uint index)
+		{
 			if (index >= RawString.Length)
 			{
-				return null;
+				return false;
 			}
 
-			/* If we can't find it in the lookup table, let's search for it in the raw string (this is very slow). */
+			var terminator = FindTerminator(index);
 
-			var substring = RawString[(int) index..];
-			var end = substring.IndexOf('\0');
+			return terminator < Count && index == GetStartIndex(terminator);
+		}
+
+		/// <summary>
+		/// Finds the position of the first terminator at or after <paramref name="index"/> in <see cref="_terminators"/>.
+		/// </summary>
+		private int FindTerminator(uint index)
+		{
+			var found = Array.BinarySearch(_terminators, (int) index);
 
-			return new(substring[..end], index, Global);
+			return found >= 0 ? found : ~found;
 		}
 
-		public bool Has(uint index) => _table.ContainsKey(index);
+		private uint GetStartIndex(int terminator) => terminator <= 0 ? 0 : (uint) _terminators[terminator - 1] + 1;
+
+		private StringTableEntry CreateEntry(uint index, int terminator)
+		{
+			// The last string might not be terminated in a malformed file, so just read to the end.
+			var end = terminator < Count ? _terminators[terminator] : RawString.Length;
+
+			return new(RawString[(int) index..end], index, Global);
+		}
 
 		public void Visit(DisassemblyWriter writer)
 		{
@@ -98,8 +139,11 @@ namespace DSO.Loader
 			writer.WriteCommentLine($" {(Global ? "Global" : "Function")} String Table ({Count} {(Count == 1 ? "entry" : "entries")})");
 			writer.WriteCommentLine("");
 
-			foreach (var (address, str) in _table)
+			for (var i = 0; i < Count; i++)
 			{
+				var address = GetStartIndex(i);
+				var str = _entries[i] ??= CreateEntry(address, i);
+
 				writer.WriteCommentLine(string.Format("     {0,-16}    =>    \"{1}\"", address, Util.String.EscapeString(str.Value)));
 			}
 
@@ -8,6 +8,8 @@
  * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
  */
 
+using System.Buffers.Binary;
+
 namespace DSO.Loader
 {
 	public class FileLoaderException : Exception
@@ -24,12 +26,25 @@ namespace DSO.Loader
 	{
 		static public uint ReadFileVersion(string filePath)
 		{
-			var reader = new FileReader(filePath);
-			var version = reader.ReadUInt();
+			using var stream = new FileStream(filePath, FileMode.Open, FileAccess.Read, FileShare.Read, bufferSize: 1);
+			Span<byte> version = stackalloc byte[sizeof(uint)];
+
+			stream.ReadExactly(version);
+
+			return ReadFileVersion(version);
+		}
 
-			reader.Close();
+		/// <exception cref="FileLoaderException">
+		/// Throws if there aren't enough bytes for a version number.
+		/// </exception>
+		static public uint ReadFileVersion(ReadOnlySpan<byte> bytes)
+		{
+			if (bytes.Length < sizeof(uint))
+			{
+				throw new FileLoaderException("File is too small to be a DSO file");
+			}
 
-			return version;
+			return BinaryPrimitives.ReadUInt32LittleEndian(bytes);
 		}
 
 		protected FileReader _reader = new();
@@ -45,6 +60,22 @@ namespace DSO.Loader
 			_reader?.Close();
 			_reader = new(filePath);
 
+			return Load();
+		}
+
+		/// <summary>
+		/// Parses a DSO file that has already been read into memory.
+		/// </summary>
+		public virtual FileData LoadFile(ReadOnlySpan<byte> bytes)
+		{
+			_reader?.Close();
+			_reader = new(bytes);
+
+			return Load();
+		}
+
+		private FileData Load()
+		{
 			var data = ReadHeader();
 
 			ReadTables(data);
@@ -115,10 +146,7 @@ namespace DSO.Loader
 
 			data.Code = new uint[size];
 
-			for (uint i = 0; i < size; i++)
-			{
-				data.Code[i] = _reader.ReadOp();
-			}
+			_reader.ReadOps(data.Code);
 
 			return new(size, lineBreaks);
 		}
@@ -127,15 +155,7 @@ namespace DSO.Loader
 		/// To be perfectly honest, I don't really know what the line break stuff is for, but it's
 		/// part of the file format so we have to parse it.
 		/// </summary>
-		protected virtual void ReadLineBreaks(uint codeSize, uint lineBreaks)
-		{
-			var totalSize = codeSize + lineBreaks * 2;
-
-			for (uint i = codeSize; i < totalSize; i++)
-			{
-				_reader.ReadUInt();
-			}
-		}
+		protected virtual void ReadLineBreaks(uint codeSize, uint lineBreaks) => _reader.Skip(checked(lineBreaks * 2 * sizeof(uint)));
 
 		/// <summary>
 		/// Reads identifier table to insert proper string table indices into parts of the code.
@@ -8,31 +8,67 @@
  * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
  */
 
+using System.Buffers;
+using System.Buffers.Binary;
+using System.Text;
+
 namespace DSO.Loader
 {
 	/// <summary>
-	/// Mostly a wrapper for BinaryReader, but with some added methods specifically for DSO file reading.
+	/// Transforms raw bytes in place (e.g. to decrypt them).
+	/// </summary>
+	public delegate void ByteDecoder(Span<byte> bytes);
+
+	/// <summary>
+	/// Reads a whole DSO file into a pooled buffer in one go and then parses it from memory, with some added
+	/// methods specifically for DSO file reading.
 	/// </summary>
 	public class FileReader
 	{
-		private readonly BinaryReader reader = null;
+		private byte[]? _buffer = null;
+		private int _length = 0;
+		private int _position = 0;
 
-		public bool IsEOF => reader.BaseStream.Position >= reader.BaseStream.Length;
+		public bool IsEOF => _position >= _length;
 
 		public FileReader() { }
 
 		public FileReader(string filePath)
 		{
-			reader = new(new FileStream(filePath, FileMode.Open));
+			using var stream = new FileStream(filePath, FileMode.Open, FileAccess.Read, FileShare.Read, bufferSize: 1, FileOptions.SequentialScan);
+
+			_length = checked((int) stream.Length);
+			_buffer = ArrayPool<byte>.Shared.Rent(_length);
+
+			stream.ReadExactly(_buffer, 0, _length);
 		}
 
-		~FileReader() => reader?.Close();
+		/// <summary>
+		/// Reads from a copy of <paramref name="bytes"/>, since some loaders decode data in place.
+		/// </summary>
+		public FileReader(ReadOnlySpan<byte> bytes)
+		{
+			_length = bytes.Length;
+			_buffer = ArrayPool<byte>.Shared.Rent(_length);
 
-		public void Close() => reader?.Close();
+			bytes.CopyTo(_buffer);
+		}
 
-		public byte ReadByte() => reader.ReadByte();
-		public uint ReadUInt() => reader.ReadUInt32();
-		public double ReadDouble() => reader.ReadDouble();
+		public void Close()
+		{
+			if (_buffer != null)
+			{
+				ArrayPool<byte>.Shared.Return(_buffer);
+			}
+
+			_buffer = null;
+			_length = 0;
+			_position = 0;
+		}
+
+		public byte ReadByte() => ReadBytes(sizeof(byte))[0];
+		public uint ReadUInt() => BinaryPrimitives.ReadUInt32LittleEndian(ReadBytes(sizeof(uint)));
+		public double ReadDouble() => BinaryPrimitives.ReadDoubleLittleEndian(ReadBytes(sizeof(double)));
 
 		public uint ReadOp()
 		{
@@ -41,18 +77,81 @@ namespace DSO.Loader
 			return op == 0xFF ? ReadUInt() : op;
 		}
 
+		/// <summary>
+		/// Reads a whole code stream in one pass. Ops are either one byte, or 0xFF followed by a 4-byte value.
+		/// </summary>
+		public void ReadOps(uint[] code)
+		{
+			var bytes = _buffer.AsSpan(_position, _length - _position);
+			var position = 0;
+
+			for (var i = 0; i < code.Length; i++)
+			{
+				if (position >= bytes.Length)
+				{
+					throw new EndOfStreamException();
+				}
+
+				var op = bytes[position++];
+
+				if (op == 0xFF)
+				{
+					if (bytes.Length - position < sizeof(uint))
+					{
+						throw new EndOfStreamException();
+					}
+
+					code[i] = BinaryPrimitives.ReadUInt32LittleEndian(bytes[position..]);
+					position += sizeof(uint);
+				}
+				else
+				{
+					code[i] = op;
+				}
+			}
+
+			_position += position;
+		}
+
+		/// <summary>
+		/// Returns a view of the next <paramref name="count"/> bytes. It is only valid until the reader is closed.
+		/// </summary>
+		public ReadOnlySpan<byte> ReadBytes(uint count) => Take(count);
+
+		public void Skip(uint bytes) => Take(bytes);
+
 		public string ReadString() => ReadString(ReadUInt());
 
-		public string ReadString(uint chars)
+		/// <summary>
+		/// DSO strings are just raw bytes, so each byte maps directly to a character (i.e. Latin-1).
+		/// </summary>
+		public string ReadString(uint chars) => Encoding.Latin1.GetString(Take(chars));
+
+		/// <summary>
+		/// Reads a string, but lets <paramref name="decode"/> transform its raw bytes first. This is done in place
+		/// in the read buffer, so it doesn't cost an extra copy.
+		/// </summary>
+		public string ReadString(ByteDecoder decode)
 		{
-			string str = "";
+			var bytes = Take(ReadUInt());
+
+			decode(bytes);
+
+			return Encoding.Latin1.GetString(bytes);
+		}
 
-			for (uint i = 0; i < chars; i++)
+		private Span<byte> Take(uint count)
+		{
+			if (count > _length - _position)
 			{
-				str += (char) ReadByte();
+				throw new EndOfStreamException();
 			}
 
-			return str;
+			var bytes = _buffer.AsSpan(_position, (int) count);
+
+			_position += (int) count;
+
+			return bytes;
 		}
 	}
 }
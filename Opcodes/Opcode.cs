@@ -19,9 +19,9 @@ namespace DSO.Opcodes
 
 	public class OpcodeData
 	{
-		public OpcodeTag Tag { get; set; } = OpcodeTag.OP_INVALID;
-		public ReturnValue ReturnValue { get; set; }
-		public TypeReq TypeReq { get; set; }
+		public OpcodeTag Tag { get; init; } = OpcodeTag.OP_INVALID;
+		public ReturnValue ReturnValue { get; init; }
+		public TypeReq TypeReq { get; init; }
 
 		public override bool Equals(object? obj) => obj is OpcodeData data
 			&& Equals(data.Tag, Tag)
@@ -32,14 +32,12 @@ namespace DSO.Opcodes
 	}
 
 
+	/// <summary>
+	/// Opcodes are immutable and shared between every instruction that uses them (see <see cref="Ops.GetOpcode"/>).
+	/// </summary>
 	public class Opcode(uint value, OpcodeData data)
 	{
-		static public Opcode? Create(uint value, Ops ops) => !ops.IsValid(value) ? null : new(value, new()
-		{
-			Tag = ops.GetOpcodeTag(value),
-			ReturnValue = ops.GetReturnValue(value),
-			TypeReq = ops.GetTypeReq(value),
-		});
+		static public Opcode? Create(uint value, Ops ops) => ops.GetOpcode(value);
 
 		public readonly uint Value = value;
 		private readonly OpcodeData Data = data;
@@ -257,6 +257,12 @@ namespace DSO.Opcodes
 
 		protected Dictionary<uint, OpcodeTag> _tags = [];
 
+		/// <summary>
+		/// Every valid opcode, fully decoded and indexed by its raw value. This gets built once, so decoding an op is
+		/// just an array lookup, and every instruction with the same op shares the same <see cref="Opcode"/>.
+		/// </summary>
+		private readonly Opcode?[] _opcodes = [];
+
 		public Ops()
 		{
 			_tags = new()
@@ -389,8 +395,25 @@ namespace DSO.Opcodes
 			{
 				_tags[OP_UNUSED3] = OpcodeTag.OP_UNUSED3;
 			}
+
+			_opcodes = new Opcode?[_tags.Keys.Max() + 1];
+
+			foreach (var value in _tags.Keys)
+			{
+				if (IsValid(value))
+				{
+					_opcodes[value] = new(value, new()
+					{
+						Tag = GetOpcodeTag(value),
+						ReturnValue = GetReturnValue(value),
+						TypeReq = GetTypeReq(value),
+					});
+				}
+			}
 		}
 
+		public Opcode? GetOpcode(uint value) => value < _opcodes.Length ? _opcodes[value] : null;
+
 		public bool IsValid(uint value) => _tags.ContainsKey(value) && value != OP_INVALID;
 
 		public OpcodeTag GetOpcodeTag(uint op) => _tags.TryGetValue(op, out OpcodeTag tag) ? tag : OpcodeTag.OP_INVALID;
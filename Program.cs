@@ -9,55 +9,54 @@
  */
 
 using DSO;
+using DSO.Benchmark;
+using DSO.Server;
 using DSO.Util;
 using static DSO.Constants.Decompiler;
 
-Console.Title = $"DSO Sharp ({VERSION})";
-
 var (error, options) = CommandLineParser.Parse(args);
-var exitImmediately = options.CommandLineMode;
+var exitImmediately = options.CommandLineMode || options.Server;
 var errorCode = error ? 1 : 0;
 
+// When either end isn't a console (like when it's run from a script without -X), there's nobody to press a key at
+// the end, and nobody looking at the window title.
+var interactive = !exitImmediately && !Console.IsInputRedirected && !Console.IsOutputRedirected;
+
+if (interactive)
+{
+	Console.Title = $"DSO Sharp ({VERSION})";
+}
+
 if (!error)
 {
-	Logger.Quiet = options.Quiet;
+	Logger.Level = options.Quiet ? LogLevel.Quiet : options.LogLevel;
 
-	if (!options.CommandLineMode)
+	if (!exitImmediately)
 	{
 		Logger.LogHeader();
 	}
 
-	new Decompiler().Decompile(options);
-}
-
-if (!exitImmediately)
-{
-	// The input is "redirected" when the program is called from a terminal.
-	var redirected = Console.IsInputRedirected;
-
-	if (redirected)
+	if (options.Server)
 	{
-		Console.WriteLine("\nPress enter key to exit...\n");
+		// Nothing gets logged outside of requests, so the standard output can be used for responses.
+		errorCode = new RequestServer(options).Run() ? 0 : 1;
 	}
-	else
+	else if (options.Benchmark)
 	{
-		Console.WriteLine("\nPress any key to exit...\n");
+		errorCode = new BenchmarkRunner().Run(options) ? 0 : 1;
 	}
-
-	while (true)
+	else
 	{
-		if (redirected)
-		{
-			if (Console.In.Peek() >= 0)
-			{
-				break;
-			}
-		}
-		else if (Console.KeyAvailable && Console.ReadKey(true).Key != ConsoleKey.None)
-		{
-			break;
-		}
+		new Decompiler().Decompile(options);
 	}
 }
 
+Logger.WaitForWrites();
+
+if (interactive)
+{
+	Console.WriteLine("\nPress any key to exit...\n");
+	Console.ReadKey(intercept: true);
+}
+
 return errorCode;
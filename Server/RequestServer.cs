@@ -0,0 +1,373 @@
+﻿/**
+ * RequestServer.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.Util;
+using DSO.Versions;
+using System.Buffers;
+using System.Diagnostics;
+using System.Net.Sockets;
+using System.Text;
+using System.Text.Encodings.Web;
+using System.Text.Json;
+
+using static DSO.Util.CommandLineOptions;
+
+namespace DSO.Server
+{
+	public class RequestException : Exception
+	{
+		public RequestException() { }
+		public RequestException(string message) : base(message) { }
+		public RequestException(string message, Exception inner) : base(message, inner) { }
+	}
+
+	/// <summary>
+	/// Decompiles files on request without restarting, so that a pipeline that decompiles files one at a time
+	/// only pays for startup once. The ops tables, output caches, and builders all stay loaded between requests.<br/><br/>
+	///
+	/// Requests and responses are JSON objects, one per line. A request looks like this (everything but the path
+	/// is optional, and defaults to whatever was passed in on the command line):
+	///
+	/// <code>
+	/// { "id": 1, "path": "scripts/main.cs.dso", "game": "tge14", "disassembly": false, "cache": true, "jobs": 4 }
+	/// </code>
+	///
+	/// <c>"paths"</c> can be used instead of <c>"path"</c> to pass in an array, and <c>"disassembly"</c> can also be
+	/// <c>"only"</c>. The response echoes the ID back along with the results and every message that would have
+	/// been logged:
+	///
+	/// <code>
+	/// { "id": 1, "success": true, "files": 1, "failures": 0, "milliseconds": 12, "log": [ ... ] }
+	/// </code>
+	///
+	/// Sending <c>{ "command": "exit" }</c> stops the server. Requests are handled one at a time, in the order they
+	/// come in.
+	/// </summary>
+	public class RequestServer(CommandLineOptions defaults)
+	{
+		private readonly CommandLineOptions _defaults = defaults;
+		private readonly Decompiler _decompiler = new();
+		private readonly UTF8Encoding _encoding = new(encoderShouldEmitUTF8Identifier: false);
+
+		public bool Run()
+		{
+			try
+			{
+				if (_defaults.SocketPath == null)
+				{
+					Serve(Console.In, Console.Out);
+				}
+				else
+				{
+					ServeSocket(_defaults.SocketPath);
+				}
+			}
+			catch (Exception exception)
+			{
+				Console.Error.WriteLine($"[ERROR] {exception.Message}");
+
+				return false;
+			}
+
+			return true;
+		}
+
+		private void ServeSocket(string path)
+		{
+			// A socket file left behind by a server that didn't shut down cleanly would keep us from binding.
+			File.Delete(path);
+
+			using var listener = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified);
+
+			listener.Bind(new UnixDomainSocketEndPoint(path));
+			listener.Listen();
+
+			Console.Error.WriteLine($"Listening on \"{path}\"");
+
+			try
+			{
+				var running = true;
+
+				while (running)
+				{
+					using var socket = listener.Accept();
+
+					try
+					{
+						using var stream = new NetworkStream(socket, ownsSocket: false);
+						using var reader = new StreamReader(stream, _encoding);
+						using var writer = new StreamWriter(stream, _encoding);
+
+						running = Serve(reader, writer);
+					}
+					catch (IOException exception)
+					{
+						// The client went away in the middle of a request, which only ends its own connection.
+						Console.Error.WriteLine($"[WARNING] Connection closed: {exception.Message}");
+					}
+				}
+			}
+			finally
+			{
+				File.Delete(path);
+			}
+		}
+
+		/// <summary>
+		/// Handles requests until the input ends or an exit command comes in.
+		/// </summary>
+		/// <returns>
+		/// <see langword="false"/> if the server should stop.
+		/// </returns>
+		private bool Serve(TextReader reader, TextWriter writer)
+		{
+			string? line;
+
+			while ((line = reader.ReadLine()) != null)
+			{
+				if (string.IsNullOrWhiteSpace(line))
+				{
+					continue;
+				}
+
+				var buffer = new ArrayBufferWriter<byte>();
+				var running = true;
+
+				try
+				{
+					// Paths and messages don't need to be safe to put in HTML, so don't escape quotes and such.
+					using var json = new Utf8JsonWriter(buffer, new() { Encoder = JavaScriptEncoder.UnsafeRelaxedJsonEscaping });
+
+					running = HandleRequest(line, json);
+				}
+				catch (Exception exception)
+				{
+					// The response could have been left half-written, so start over with just the error.
+					buffer.Clear();
+					WriteError(buffer, exception);
+				}
+
+				writer.WriteLine(_encoding.GetString(buffer.WrittenSpan));
+				writer.Flush();
+
+				if (!running)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		private bool HandleRequest(string line, Utf8JsonWriter writer)
+		{
+			writer.WriteStartObject();
+
+			try
+			{
+				using var document = JsonDocument.Parse(line);
+
+				var request = document.RootElement;
+
+				if (request.ValueKind != JsonValueKind.Object)
+				{
+					throw new RequestException("Request is not an object");
+				}
+
+				if (request.TryGetProperty("id", out JsonElement id))
+				{
+					writer.WritePropertyName("id");
+					id.WriteTo(writer);
+				}
+
+				var command = GetString(request, "command") ?? "decompile";
+
+				switch (command)
+				{
+					case "exit":
+						writer.WriteBoolean("success", true);
+						writer.WriteEndObject();
+
+						return false;
+
+					case "decompile":
+						Decompile(CreateOptions(request), writer);
+						break;
+
+					default:
+						throw new RequestException($"Unknown command '{command}'");
+				}
+			}
+			catch (Exception exception)
+			{
+				// Whatever goes wrong with one request shouldn't take the whole server down with it.
+				writer.WriteBoolean("success", false);
+				writer.WriteString("error", exception.Message);
+			}
+
+			writer.WriteEndObject();
+
+			return true;
+		}
+
+		static private void WriteError(IBufferWriter<byte> buffer, Exception exception)
+		{
+			using var writer = new Utf8JsonWriter(buffer, new() { Encoder = JavaScriptEncoder.UnsafeRelaxedJsonEscaping });
+
+			writer.WriteStartObject();
+			writer.WriteBoolean("success", false);
+			writer.WriteString("error", exception.Message);
+			writer.WriteEndObject();
+		}
+
+		private void Decompile(CommandLineOptions options, Utf8JsonWriter writer)
+		{
+			var stopwatch = Stopwatch.StartNew();
+			Tuple<int, int>? result;
+
+			Logger.BeginCapture();
+
+			try
+			{
+				result = _decompiler.Decompile(options);
+			}
+			catch (Exception exception)
+			{
+				Logger.LogError(exception.Message);
+				result = null;
+			}
+
+			var log = Logger.EndCapture();
+
+			writer.WriteBoolean("success", result != null && result.Item2 <= 0);
+			writer.WriteNumber("files", result?.Item1 ?? 0);
+			writer.WriteNumber("failures", result?.Item2 ?? 0);
+			writer.WriteNumber("milliseconds", stopwatch.ElapsedMilliseconds);
+			writer.WriteStartArray("log");
+
+			foreach (var entry in log)
+			{
+				writer.WriteStringValue(entry.Message);
+			}
+
+			writer.WriteEndArray();
+		}
+
+		private CommandLineOptions CreateOptions(JsonElement request)
+		{
+			var options = new CommandLineOptions
+			{
+				GameIdentifier = _defaults.GameIdentifier,
+				Quiet = _defaults.Quiet,
+				LogLevel = _defaults.LogLevel,
+				OutputDisassembly = _defaults.OutputDisassembly,
+				CommandLineMode = true,
+				Jobs = _defaults.Jobs,
+				ParallelFunctions = _defaults.ParallelFunctions,
+				UseCache = _defaults.UseCache,
+				StatisticsPath = _defaults.StatisticsPath,
+				OutputPath = _defaults.OutputPath,
+				IndexPath = _defaults.IndexPath,
+			};
+
+			if (GetString(request, "path") is string path)
+			{
+				options.Paths.Add(path);
+			}
+
+			if (request.TryGetProperty("paths", out JsonElement paths))
+			{
+				if (paths.ValueKind != JsonValueKind.Array)
+				{
+					throw new RequestException("'paths' is not an array");
+				}
+
+				foreach (var element in paths.EnumerateArray())
+				{
+					if (element.ValueKind != JsonValueKind.String)
+					{
+						throw new RequestException("'paths' contains a non-string");
+					}
+
+					options.Paths.Add(element.GetString()!);
+				}
+			}
+
+			if (options.Paths.Count <= 0)
+			{
+				throw new RequestException("No file or directory path(s) specified");
+			}
+
+			if (GetString(request, "game") is string game)
+			{
+				if (!CommandLineParser.TryParseGame(game, out GameIdentifier identifier))
+				{
+					throw new RequestException($"Unsupported game '{game}'");
+				}
+
+				options.GameIdentifier = identifier;
+			}
+
+			if (request.TryGetProperty("disassembly", out JsonElement disassembly))
+			{
+				options.OutputDisassembly = disassembly.ValueKind switch
+				{
+					JsonValueKind.True => DisassemblyOutput.Disassembly,
+					JsonValueKind.False => DisassemblyOutput.None,
+					JsonValueKind.String when disassembly.GetString() == "only" => DisassemblyOutput.DisassemblyOnly,
+					_ => throw new RequestException("'disassembly' must be true, false, or \"only\""),
+				};
+			}
+
+			if (request.TryGetProperty("jobs", out JsonElement jobs))
+			{
+				if (jobs.ValueKind != JsonValueKind.Number || !jobs.TryGetInt32(out int count) || count < 1)
+				{
+					throw new RequestException("'jobs' must be a positive integer");
+				}
+
+				options.Jobs = count;
+			}
+
+			options.UseCache = GetBool(request, "cache") ?? options.UseCache;
+			options.ParallelFunctions = GetBool(request, "parallelFunctions") ?? options.ParallelFunctions;
+			options.StatisticsPath = GetString(request, "statistics") ?? options.StatisticsPath;
+			options.OutputPath = GetString(request, "output") ?? options.OutputPath;
+			options.IndexPath = GetString(request, "index") ?? options.IndexPath;
+
+			return options;
+		}
+
+		static private string? GetString(JsonElement request, string name)
+		{
+			if (!request.TryGetProperty(name, out JsonElement element))
+			{
+				return null;
+			}
+
+			return element.ValueKind == JsonValueKind.String ? element.GetString() : throw new RequestException($"'{name}' is not a string");
+		}
+
+		static private bool? GetBool(JsonElement request, string name)
+		{
+			if (!request.TryGetProperty(name, out JsonElement element))
+			{
+				return null;
+			}
+
+			return element.ValueKind switch
+			{
+				JsonValueKind.True => true,
+				JsonValueKind.False => false,
+				_ => throw new RequestException($"'{name}' is not a boolean"),
+			};
+		}
+	}
+}
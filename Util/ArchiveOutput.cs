@@ -0,0 +1,89 @@
+﻿/**
+ * ArchiveOutput.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using System.Collections.Concurrent;
+using System.IO.Compression;
+using System.Text;
+
+using static DSO.Constants.Decompiler;
+
+namespace DSO.Util
+{
+	/// <summary>
+	/// Collects the output files of everything decompiled from an archive, then writes them all to a new archive
+	/// next to it, or in the output directory if there is one (<c>addon.zip</c> becomes
+	/// <c>addon_decompiled.zip</c>). Each output file keeps the same path inside the new archive that its DSO file
+	/// had in the original.
+	/// </summary>
+	public class ArchiveOutput(string archivePath, string? outputDirectory, Encoding encoding)
+	{
+		private readonly string _root = Path.GetFullPath(archivePath);
+		private readonly Encoding _encoding = encoding;
+		private readonly ConcurrentDictionary<string, byte[]> _entries = new();
+
+		public readonly string OutputPath = Path.Join(outputDirectory ?? Path.GetDirectoryName(archivePath),
+			$"{Path.GetFileNameWithoutExtension(archivePath)}{ARCHIVE_OUTPUT_SUFFIX}{ARCHIVE_EXTENSION}");
+
+		public int Count => _entries.Count;
+
+		/// <summary>
+		/// Output paths are built from the path of the DSO file as if the archive was a directory, so this turns
+		/// one back into a path inside the archive.
+		/// </summary>
+		public string GetEntryName(string outputPath) => Path.GetRelativePath(_root, Path.GetFullPath(outputPath)).Replace('\\', '/');
+
+		public string GetDisplayPath(string outputPath) => $"{OutputPath}/{GetEntryName(outputPath)}";
+
+		public void Write(string outputPath, Action<TextWriter> write)
+		{
+			using var stream = new MemoryStream();
+
+			using (var writer = new StreamWriter(stream, _encoding, OUTPUT_BUFFER_SIZE, leaveOpen: true))
+			{
+				write(writer);
+			}
+
+			_entries[GetEntryName(outputPath)] = stream.ToArray();
+		}
+
+		/// <summary>
+		/// Writes the archive to a temporary file first and then moves it into place, so a failed write can't
+		/// leave a broken archive behind.
+		/// </summary>
+		/// <exception cref="IOException">
+		/// Throws if the archive could not be written.
+		/// </exception>
+		public void Save()
+		{
+			var tempPath = $"{OutputPath}{TEMP_EXTENSION}";
+
+			try
+			{
+				using (var stream = new FileStream(tempPath, FileMode.Create, FileAccess.Write, FileShare.None, OUTPUT_BUFFER_SIZE))
+				using (var archive = new ZipArchive(stream, ZipArchiveMode.Create))
+				{
+					foreach (var (name, bytes) in _entries.OrderBy(entry => entry.Key, StringComparer.Ordinal))
+					{
+						using var entryStream = archive.CreateEntry(name).Open();
+
+						entryStream.Write(bytes);
+					}
+				}
+
+				File.Move(tempPath, OutputPath, overwrite: true);
+			}
+			catch (Exception)
+			{
+				File.Delete(tempPath);
+				throw;
+			}
+		}
+	}
+}
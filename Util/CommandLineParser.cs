@@ -8,6 +8,7 @@
  * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
  */
 
+using DSO.Benchmark;
 using DSO.Versions;
 using static DSO.Constants.Decompiler;
 using static DSO.Util.CommandLineOptions;
@@ -27,8 +28,36 @@ namespace DSO.Util
 
 		public GameIdentifier GameIdentifier { get; set; } = GameIdentifier.Auto;
 		public bool Quiet { get; set; } = false;
+		public LogLevel LogLevel { get; set; } = LogLevel.Normal;
 		public DisassemblyOutput OutputDisassembly { get; set; } = DisassemblyOutput.None;
 		public bool CommandLineMode { get; set; } = false;
+		public int Jobs { get; set; } = 1;
+		public bool ParallelFunctions { get; set; } = false;
+		public bool UseCache { get; set; } = false;
+		public bool Benchmark { get; set; } = false;
+
+		/// <summary>
+		/// What to generate for the benchmarks instead of the built-in file shapes, or null to use those.
+		/// </summary>
+		public FileGeneratorSettings? BenchmarkSettings { get; set; } = null;
+
+		public string? StatisticsPath { get; set; } = null;
+
+		/// <summary>
+		/// Where to write the symbol index, or null to decompile files like normal (see <see cref="SymbolIndex"/>).
+		/// </summary>
+		public string? IndexPath { get; set; } = null;
+
+		/// <summary>
+		/// Where output files go, mirroring the directories that were passed in, or null to put them next to each file.
+		/// </summary>
+		public string? OutputPath { get; set; } = null;
+		public bool Server { get; set; } = false;
+
+		/// <summary>
+		/// The Unix domain socket the server listens on, or null to read requests from the standard input.
+		/// </summary>
+		public string? SocketPath { get; set; } = null;
 	}
 
 	static public class CommandLineParser
@@ -46,6 +75,16 @@ namespace DSO.Util
 			{ "blv21", GameIdentifier.BlocklandV21 },
 		};
 
+		static private readonly Dictionary<string, LogLevel> _logLevels = new()
+		{
+			{ "quiet", LogLevel.Quiet },
+			{ "errors", LogLevel.Errors },
+			{ "warnings", LogLevel.Warnings },
+			{ "normal", LogLevel.Normal },
+		};
+
+		static public bool TryParseGame(string game, out GameIdentifier identifier) => _gameIdentifiers.TryGetValue(game, out identifier);
+
 		static public Tuple<bool, CommandLineOptions> Parse(string[] args)
 		{
 			var firstFlagSet = false;
@@ -81,6 +120,28 @@ namespace DSO.Util
 						options.Quiet = true;
 						break;
 
+					case "-v":
+					{
+						error = i >= args.Length - 1 || args[i + 1].StartsWith('-');
+
+						if (error)
+						{
+							Logger.LogError($"Missing log level after '{arg}'");
+						}
+						else if (!_logLevels.TryGetValue(args[i + 1], out LogLevel level))
+						{
+							Logger.LogError($"Unsupported log level '{args[i + 1]}' (expected {string.Join(", ", _logLevels.Keys.Select(key => $"'{key}'"))})");
+							error = true;
+						}
+						else
+						{
+							options.LogLevel = level;
+							i++;
+						}
+
+						break;
+					}
+
 					case "-d":
 						if (options.OutputDisassembly == DisassemblyOutput.None)
 						{
@@ -133,6 +194,113 @@ namespace DSO.Util
 						break;
 					}
 
+					case "-s":
+					{
+						error = i >= args.Length - 1 || args[i + 1].StartsWith('-');
+
+						if (error)
+						{
+							Logger.LogError($"Missing file path after '{arg}'");
+						}
+						else
+						{
+							options.StatisticsPath = args[i + 1];
+							i++;
+						}
+
+						break;
+					}
+
+					case "-i":
+					{
+						error = i >= args.Length - 1 || args[i + 1].StartsWith('-');
+
+						if (error)
+						{
+							Logger.LogError($"Missing file path after '{arg}'");
+						}
+						else
+						{
+							options.IndexPath = args[i + 1];
+							i++;
+						}
+
+						break;
+					}
+
+					case "-o":
+					{
+						error = i >= args.Length - 1 || args[i + 1].StartsWith('-');
+
+						if (error)
+						{
+							Logger.LogError($"Missing directory path after '{arg}'");
+						}
+						else
+						{
+							options.OutputPath = args[i + 1];
+							i++;
+						}
+
+						break;
+					}
+
+					case "-b":
+						options.Benchmark = true;
+
+						// The generator settings are optional. They always have an '=' in them, so they can't be
+						// mistaken for a path.
+						if (i < args.Length - 1 && args[i + 1].Contains('='))
+						{
+							options.BenchmarkSettings = ParseBenchmarkSettings(args[i + 1]);
+							error = options.BenchmarkSettings == null;
+							i++;
+						}
+
+						break;
+
+					case "-l":
+						options.Server = true;
+
+						// The socket path is optional.
+						if (i < args.Length - 1 && !args[i + 1].StartsWith('-'))
+						{
+							options.SocketPath = args[i + 1];
+							i++;
+						}
+
+						break;
+
+					case "-c":
+						options.UseCache = true;
+						break;
+
+					case "-p":
+						options.ParallelFunctions = true;
+						break;
+
+					case "-j":
+					{
+						error = i >= args.Length - 1 || args[i + 1].StartsWith('-');
+
+						if (error)
+						{
+							Logger.LogError($"Missing job count after '{arg}'");
+						}
+						else if (!int.TryParse(args[i + 1], out int jobs) || jobs < 1)
+						{
+							Logger.LogError($"Invalid job count '{args[i + 1]}'");
+							error = true;
+						}
+						else
+						{
+							options.Jobs = jobs;
+							i++;
+						}
+
+						break;
+					}
+
 					default:
 					{
 						if (!arg.StartsWith('-'))
@@ -151,7 +319,7 @@ namespace DSO.Util
 						{
 							Logger.LogError($"Unknown or unsupported flag '{arg}'\n");
 
-							if (arg == "-H" || arg == "-Q" || arg == "-G")
+							if (arg == "-H" || arg == "-Q" || arg == "-G" || arg == "-J" || arg == "-C" || arg == "-B" || arg == "-S" || arg == "-P" || arg == "-L" || arg == "-O" || arg == "-I" || arg == "-V")
 							{
 								Logger.LogError($"Did you mean '{arg.ToLower()}'?");
 							}
@@ -181,7 +349,7 @@ namespace DSO.Util
 					DisplayHelp();
 				}
 			}
-			else if (options.Paths.Count <= 0)
+			else if (options.Paths.Count <= 0 && !options.Benchmark && !options.Server)
 			{
 				if (!options.Quiet && !options.CommandLineMode)
 				{
@@ -197,16 +365,83 @@ namespace DSO.Util
 			return new(error, options);
 		}
 
+		/// <summary>
+		/// Parses generator settings like <c>functions=64,depth=4</c>. Anything that's left out keeps its default.
+		/// </summary>
+		static private FileGeneratorSettings? ParseBenchmarkSettings(string arg)
+		{
+			var settings = new FileGeneratorSettings { Name = "custom" };
+
+			foreach (var setting in arg.Split(','))
+			{
+				var parts = setting.Split('=', 2);
+
+				if (parts.Length != 2 || !int.TryParse(parts[1], out int value) || value < 0)
+				{
+					Logger.LogError($"Invalid benchmark setting '{setting}'");
+
+					return null;
+				}
+
+				switch (parts[0])
+				{
+					case "functions":
+						settings.Functions = value;
+						break;
+
+					case "depth":
+						settings.NestingDepth = value;
+						break;
+
+					case "strings":
+						settings.Strings = value;
+						break;
+
+					case "branches":
+						settings.Branches = value;
+						break;
+
+					default:
+						Logger.LogError($"Unknown benchmark setting '{parts[0]}' (expected 'functions', 'depth', 'strings', or 'branches')");
+
+						return null;
+				}
+			}
+
+			return settings;
+		}
+
 		static private void DisplayHelp()
 		{
 			Logger.LogMessage(
-				"usage: dso-sharp path1[, path2[, ...]] [-h] [-q] [-g game] [-d | -D] [-X]\n" +
+				"usage: dso-sharp path1[, path2[, ...]] [-h] [-q] [-v level] [-g game] [-d | -D] [-o dir] [-j jobs] [-p] [-c] [-s file] [-i file] [-b [settings]] [-l [socket]] [-X]\n" +
 				"  options:\n" +
 				"    -h    Displays help.\n" +
 				"    -q    Disables all messages (except command-line argument errors).\n" +
+				"    -v    Sets which messages are shown: 'errors', 'warnings' (and the summary at the\n" +
+				"          end), or 'normal' (default).\n" +
 				"    -g    Specifies which game settings to use (default: 'auto').\n" +
 				"    -d    Writes a `" + DISASM_EXTENSION + "` file containing the disassembly.\n" +
 				"    -D    Writes only the disassembly file and nothing else.\n" +
+				"    -o    Writes output files to this directory instead of next to each file,\n" +
+				"          mirroring the structure of the directories passed in.\n" +
+				"    -j    Decompiles the files in directories on this many threads at once (default: 1).\n" +
+				"    -p    Builds the functions in each file on multiple threads at once (for files\n" +
+				"          with a lot of functions).\n" +
+				"    -c    Skips files that haven't changed since they were last decompiled with the same\n" +
+				"          settings (keeps track of them in a `" + CACHE_FILE_NAME + "` file).\n" +
+				"    -s    Writes how long each stage took for each file, and how much memory it\n" +
+				"          allocated, to a JSON file.\n" +
+				"    -i    Writes an index of every function and every call in the files to a JSON file\n" +
+				"          instead of decompiling them. Only files that changed since the last run\n" +
+				"          are read again.\n" +
+				"    -b    Runs benchmarks on generated files instead of decompiling anything, including\n" +
+				"          how long the program takes to start up. Use -g to only benchmark one game.\n" +
+				"          Settings like 'functions=64,depth=4,strings=256,branches=0' generate one\n" +
+				"          file of that shape instead of the built-in ones.\n" +
+				"    -l    Runs as a server that takes JSON requests, one per line, from the standard\n" +
+				"          input (or from a Unix domain socket, if a path is given). Other options\n" +
+				"          are used as the defaults for each request.\n" +
 				"    -X    Makes the program operate as a command-line interface that takes\n" +
 				"          no keyboard input and closes immediately upon completion or failure.\n"
 			);
@@ -8,45 +8,309 @@
  * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
  */
 
+using System.Collections.Concurrent;
+using System.Text;
+
 using static DSO.Constants.Decompiler;
 
 namespace DSO.Util
 {
-    static public class Logger
+	/// <summary>
+	/// How much gets logged. Each level includes everything from the levels before it.
+	/// </summary>
+	public enum LogLevel
 	{
-		static public bool Quiet = false;
+		Quiet,
+		Errors,
+
+		/// <summary>
+		/// Warnings, and the summary at the end.
+		/// </summary>
+		Warnings,
+
+		Normal,
+	}
+
+	/// <summary>
+	/// A single buffered log message (see <see cref="Logger.BeginBuffer"/>).
+	/// </summary>
+	public class LogEntry(string message, ConsoleColor? color)
+	{
+		public readonly string Message = message;
+		public readonly ConsoleColor? Color = color;
+	}
+
+	/// <summary>
+	/// Messages are written to the console on a separate thread, so that threads doing actual work never have to
+	/// wait on the console. Any thread can log at any time: messages go into a queue, and the writer thread takes
+	/// everything that's in it at once and writes it with as few writes and color changes as it can.<br/><br/>
+	///
+	/// Anything that writes to the console directly has to call <see cref="WaitForWrites"/> first, so that it
+	/// doesn't end up in the middle of messages that haven't been written yet.
+	/// </summary>
+	static public class Logger
+	{
+		static public LogLevel Level = LogLevel.Normal;
+
+		static private readonly object _lock = new();
+
+		/// <summary>
+		/// Holds <see cref="LogEntry"/> objects, lists of them that have to be written together, and events for
+		/// <see cref="WaitForWrites"/> to wait on.
+		/// </summary>
+		static private readonly ConcurrentQueue<object> _queue = new();
+		static private readonly SemaphoreSlim _queued = new(0);
+		static private Thread? _writer = null;
+
+		/// <summary>
+		/// When this is set, messages logged from the current thread get collected instead of written, so that
+		/// files decompiled concurrently can have their messages flushed in order.
+		/// </summary>
+		[ThreadStatic]
+		static private List<LogEntry>? _buffer;
+
+		/// <summary>
+		/// When this is set, messages from every thread get collected instead of written to the console (see
+		/// <see cref="BeginCapture"/>).
+		/// </summary>
+		static private List<LogEntry>? _capture = null;
 
-		static public void LogError(string message, bool indented = false) => LogMessage($"{(indented ? "\t" : "")}[ERROR] {message}", ConsoleColor.DarkRed);
-		static public void LogWarning(string message) => LogMessage($"[WARNING] {message}", ConsoleColor.Yellow);
-		static public void LogSuccess(string message) => LogMessage($"[SUCCESS] {message}", ConsoleColor.Green);
-		static public void LogMessage(string message, ConsoleColor textColor)
+		static public void LogError(string message, bool indented = false) => Log(LogLevel.Errors, $"{(indented ? "\t" : "")}[ERROR] {message}", ConsoleColor.DarkRed);
+		static public void LogWarning(string message) => Log(LogLevel.Warnings, $"[WARNING] {message}", ConsoleColor.Yellow);
+		static public void LogSuccess(string message) => Log(LogLevel.Warnings, $"[SUCCESS] {message}", ConsoleColor.Green);
+		static public void LogMessage(string message, ConsoleColor textColor) => Log(LogLevel.Normal, message, textColor);
+		static public void LogMessage(string message) => Log(LogLevel.Normal, message, null);
+
+		static public void LogMessage(string format, params object[] args)
 		{
-			var prev = Console.ForegroundColor;
+			if (Level >= LogLevel.Normal)
+			{
+				Write(string.Format(format, args), null);
+			}
+		}
 
-			Console.ForegroundColor = textColor;
-			LogMessage(message);
-			Console.ForegroundColor = prev;
+		static public void LogHeader()
+		{
+			LogMessage($"## DSO Sharp ({VERSION}) by {AUTHOR} ##\n", ConsoleColor.White);
 		}
 
-		static public void LogMessage(string message)
+		/// <summary>
+		/// Starts collecting messages logged from the current thread instead of writing them.
+		/// </summary>
+		static public void BeginBuffer() => _buffer = [];
+
+		/// <summary>
+		/// Stops collecting messages on the current thread and returns the ones that were collected.
+		/// </summary>
+		static public List<LogEntry> EndBuffer()
 		{
-			if (!Quiet)
+			var buffer = _buffer ?? [];
+
+			_buffer = null;
+
+			return buffer;
+		}
+
+		/// <summary>
+		/// Starts collecting every message instead of writing it to the console, including ones flushed from other
+		/// threads. Used by the server, where the console might be what the responses get written to.
+		/// </summary>
+		static public void BeginCapture()
+		{
+			WaitForWrites();
+
+			lock (_lock)
 			{
-				Console.WriteLine(message);
+				_capture = [];
 			}
 		}
 
-		static public void LogMessage(string format, params object[] args)
+		static public List<LogEntry> EndCapture()
 		{
-			if (!Quiet)
+			lock (_lock)
 			{
-				Console.WriteLine(format, args);
+				var capture = _capture ?? [];
+
+				_capture = null;
+
+				return capture;
 			}
 		}
 
-		static public void LogHeader()
+		/// <summary>
+		/// Writes buffered messages. They're kept together, even if other threads are logging at the same time.
+		/// </summary>
+		static public void Flush(List<LogEntry> entries)
 		{
-			LogMessage($"## DSO Sharp ({VERSION}) by {AUTHOR} ##\n", ConsoleColor.White);
+			if (entries.Count > 0 && !TryCapture(entries))
+			{
+				Enqueue(entries);
+			}
+		}
+
+		/// <summary>
+		/// Blocks until every message logged so far has been written to the console.
+		/// </summary>
+		static public void WaitForWrites()
+		{
+			if (_writer == null)
+			{
+				return;
+			}
+
+			using var written = new ManualResetEventSlim(false);
+
+			Enqueue(written);
+			written.Wait();
+		}
+
+		static private void Log(LogLevel level, string message, ConsoleColor? color)
+		{
+			if (Level >= level)
+			{
+				Write(message, color);
+			}
+		}
+
+		static private void Write(string message, ConsoleColor? color)
+		{
+			var entry = new LogEntry(message, color);
+
+			if (_buffer != null)
+			{
+				_buffer.Add(entry);
+			}
+			else if (!TryCapture([entry]))
+			{
+				Enqueue(entry);
+			}
+		}
+
+		static private bool TryCapture(List<LogEntry> entries)
+		{
+			if (_capture == null)
+			{
+				return false;
+			}
+
+			lock (_lock)
+			{
+				if (_capture == null)
+				{
+					return false;
+				}
+
+				_capture.AddRange(entries);
+
+				return true;
+			}
+		}
+
+		static private void Enqueue(object item)
+		{
+			if (_writer == null)
+			{
+				StartWriter();
+			}
+
+			_queue.Enqueue(item);
+			_queued.Release();
+		}
+
+		static private void StartWriter()
+		{
+			lock (_lock)
+			{
+				if (_writer != null)
+				{
+					return;
+				}
+
+				// A background thread doesn't keep the program running, so make sure everything gets written
+				// before it exits.
+				AppDomain.CurrentDomain.ProcessExit += (sender, args) => WaitForWrites();
+
+				_writer = new(WriteMessages) { IsBackground = true, Name = "Logger" };
+				_writer.Start();
+			}
+		}
+
+		static private void WriteMessages()
+		{
+			var output = new StringBuilder();
+			var defaultColor = Console.ForegroundColor;
+			ConsoleColor? currentColor = null;
+
+			void WriteOutput()
+			{
+				try
+				{
+					Console.Out.Write(output.ToString());
+				}
+				catch (IOException)
+				{
+					// There's nowhere left to write to (like when the output is piped to something that closed).
+				}
+
+				output.Clear();
+			}
+
+			void SetColor(ConsoleColor? color)
+			{
+				// Text only has to be written out when the color changes, since everything before it has to be in
+				// the old color.
+				if (color != currentColor)
+				{
+					WriteOutput();
+
+					Console.ForegroundColor = color ?? defaultColor;
+					currentColor = color;
+				}
+			}
+
+			void WriteEntry(LogEntry entry)
+			{
+				SetColor(entry.Color);
+				output.AppendLine(entry.Message);
+			}
+
+			while (true)
+			{
+				_queued.Wait();
+
+				var waiting = new List<ManualResetEventSlim>();
+
+				// Take everything that's in the queue at once (up to a point), including anything that got added
+				// while we were writing the last batch.
+				do
+				{
+					if (!_queue.TryDequeue(out object? item))
+					{
+						continue;
+					}
+
+					switch (item)
+					{
+						case LogEntry entry:
+							WriteEntry(entry);
+							break;
+
+						case List<LogEntry> entries:
+							entries.ForEach(WriteEntry);
+							break;
+
+						case ManualResetEventSlim written:
+							waiting.Add(written);
+							break;
+					}
+				}
+				while (output.Length < OUTPUT_BUFFER_SIZE && _queued.Wait(0));
+
+				SetColor(null);
+				WriteOutput();
+
+				waiting.ForEach(written => written.Set());
+			}
 		}
 	}
 }
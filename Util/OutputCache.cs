@@ -0,0 +1,139 @@
+﻿/**
+ * OutputCache.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using System.Collections.Concurrent;
+using System.Security.Cryptography;
+using System.Text;
+using static DSO.Constants.Decompiler;
+
+namespace DSO.Util
+{
+	/// <summary>
+	/// Keeps track of which files were decompiled, and with what settings, so that files that haven't changed can
+	/// be skipped next time.<br/><br/>
+	///
+	/// Each root directory gets its own index file. Every line in it is a file path (relative to the root) and
+	/// the key that file was last decompiled with.
+	/// </summary>
+	public class OutputCache
+	{
+		private const string HEADER = "# dso-sharp output cache";
+
+		/// <summary>
+		/// The key covers everything that affects the output: the file's contents, the game settings it was
+		/// decompiled with, the version of this program, and which output files were written.
+		/// </summary>
+		static public string CreateKey(ReadOnlySpan<byte> bytes, CommandLineOptions options)
+		{
+			return $"{Convert.ToHexString(SHA256.HashData(bytes))} {options.GameIdentifier} {VERSION} {options.OutputDisassembly}";
+		}
+
+		static public OutputCache Load(string root)
+		{
+			var cache = new OutputCache(root);
+
+			if (!File.Exists(cache._indexPath))
+			{
+				return cache;
+			}
+
+			try
+			{
+				foreach (var line in File.ReadLines(cache._indexPath))
+				{
+					if (line.StartsWith('#'))
+					{
+						continue;
+					}
+
+					var separator = line.IndexOf('\t');
+
+					if (separator > 0)
+					{
+						cache._entries[line[(separator + 1)..]] = line[..separator];
+					}
+				}
+			}
+			catch (Exception exception)
+			{
+				// A missing or broken index just means everything gets decompiled again.
+				Logger.LogWarning($"Could not read cache file \"{cache._indexPath}\": {exception.Message}");
+				cache._entries.Clear();
+			}
+
+			return cache;
+		}
+
+		private readonly string _root;
+		private readonly string _indexPath;
+		private readonly ConcurrentDictionary<string, string> _entries = new();
+		private bool _changed = false;
+
+		private OutputCache(string root)
+		{
+			_root = Path.GetFullPath(root);
+			_indexPath = Path.Join(_root, CACHE_FILE_NAME);
+		}
+
+		public bool IsUpToDate(string path, string key) => _entries.TryGetValue(GetRelativePath(path), out string? entry) && entry == key;
+
+		public void Update(string path, string key)
+		{
+			_entries[GetRelativePath(path)] = key;
+			_changed = true;
+		}
+
+		/// <summary>
+		/// Writes the index to a temporary file first and then moves it into place, so that an interrupted run
+		/// can't leave a half-written index behind.
+		/// </summary>
+		public void Save()
+		{
+			if (!_changed)
+			{
+				return;
+			}
+
+			var tempPath = $"{_indexPath}{TEMP_EXTENSION}";
+
+			try
+			{
+				var builder = new StringBuilder();
+
+				builder.Append(HEADER).Append('\n');
+
+				foreach (var (path, key) in _entries.OrderBy(entry => entry.Key, StringComparer.Ordinal))
+				{
+					builder.Append(key).Append('\t').Append(path).Append('\n');
+				}
+
+				File.WriteAllText(tempPath, builder.ToString());
+				File.Move(tempPath, _indexPath, overwrite: true);
+
+				_changed = false;
+			}
+			catch (Exception exception)
+			{
+				Logger.LogWarning($"Could not write cache file \"{_indexPath}\": {exception.Message}");
+
+				try
+				{
+					File.Delete(tempPath);
+				}
+				catch (Exception)
+				{
+					// We already logged the error that matters.
+				}
+			}
+		}
+
+		private string GetRelativePath(string path) => Path.GetRelativePath(_root, Path.GetFullPath(path)).Replace('\\', '/');
+	}
+}
@@ -0,0 +1,260 @@
+﻿/**
+ * Statistics.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.Loader;
+using DSO.Versions;
+using System.Diagnostics;
+using System.Text.Json;
+
+using static DSO.Constants.Decompiler;
+
+namespace DSO.Util
+{
+	public enum Stage
+	{
+		Read,
+		Detect,
+		Load,
+		Disassemble,
+		ControlFlow,
+		Build,
+
+		/// <summary>
+		/// Generating the script file. This includes writing it, since the code is streamed straight to the file.
+		/// </summary>
+		Generate,
+
+		WriteDisassembly,
+	}
+
+	/// <summary>
+	/// The time spent and the memory allocated by one or more runs of a stage.
+	/// </summary>
+	public class StageMeasurement
+	{
+		public long Ticks { get; private set; } = 0;
+		public long AllocatedBytes { get; private set; } = 0;
+
+		/// <summary>
+		/// Whether <see cref="AllocatedBytes"/> might include allocations from work on other files.
+		/// </summary>
+		public bool Approximate { get; private set; } = false;
+
+		public double Milliseconds => Ticks * 1000.0 / Stopwatch.Frequency;
+
+		/// <summary>
+		/// Only counts allocations on the current thread, so it still works when we're decompiling files in parallel.<br/><br/>
+		///
+		/// Stages that hand work off to other threads have to pass <paramref name="allThreads"/>, which counts everything
+		/// the process allocates while <paramref name="run"/> is going instead. That also counts whatever else is running
+		/// at the time, so those measurements are marked as approximate.
+		/// </summary>
+		public T Measure<T>(Func<T> run, bool allThreads = false)
+		{
+			var allocated = GetAllocatedBytes(allThreads);
+			var start = Stopwatch.GetTimestamp();
+
+			try
+			{
+				return run();
+			}
+			finally
+			{
+				Ticks += Stopwatch.GetTimestamp() - start;
+				AllocatedBytes += GetAllocatedBytes(allThreads) - allocated;
+				Approximate |= allThreads;
+			}
+		}
+
+		static private long GetAllocatedBytes(bool allThreads) => allThreads ? GC.GetTotalAllocatedBytes(precise: true) : GC.GetAllocatedBytesForCurrentThread();
+	}
+
+	public class FileStatistics(string path)
+	{
+		/// <summary>
+		/// Measures <paramref name="run"/> if we're keeping statistics, or just runs it if we aren't.
+		/// </summary>
+		static public T Measure<T>(FileStatistics? stats, Stage stage, Func<T> run, bool allThreads = false) => stats == null ? run() : stats.Measure(stage, run, allThreads);
+
+		public readonly string Path = path;
+		public readonly StageMeasurement?[] Stages = new StageMeasurement?[Enum.GetValues<Stage>().Length];
+
+		public bool Success { get; set; } = false;
+
+		/// <summary>
+		/// Whether the file was skipped because it hasn't changed since it was last decompiled.
+		/// </summary>
+		public bool Cached { get; set; } = false;
+
+		public GameIdentifier Game { get; set; } = GameIdentifier.Auto;
+		public long FileSize { get; set; } = 0;
+		public int CodeSize { get; private set; } = 0;
+		public int GlobalStrings { get; private set; } = 0;
+		public int FunctionStrings { get; private set; } = 0;
+		public int GlobalFloats { get; private set; } = 0;
+		public int FunctionFloats { get; private set; } = 0;
+		public int Instructions { get; set; } = 0;
+		public int TopLevelNodes { get; set; } = 0;
+		public int Nodes { get; set; } = 0;
+
+		public T Measure<T>(Stage stage, Func<T> run, bool allThreads = false) => (Stages[(int) stage] ??= new()).Measure(run, allThreads);
+
+		public void Record(FileData data)
+		{
+			CodeSize = data.Code.Length;
+			GlobalStrings = data.GlobalStringTable.Count;
+			FunctionStrings = data.FunctionStringTable.Count;
+			GlobalFloats = data.GlobalFloatTable.Count;
+			FunctionFloats = data.FunctionFloatTable.Count;
+		}
+	}
+
+	/// <summary>
+	/// Collects the statistics of every file we decompile, and writes them out as JSON along with percentiles for
+	/// each stage.
+	/// </summary>
+	public class StatisticsReport
+	{
+		static private readonly double[] _percentiles = [50.0, 90.0, 95.0, 99.0];
+
+		private readonly List<FileStatistics> _files = [];
+		private readonly object _lock = new();
+
+		public void Add(FileStatistics file)
+		{
+			lock (_lock)
+			{
+				_files.Add(file);
+			}
+		}
+
+		/// <exception cref="IOException">
+		/// Throws if the file could not be written.
+		/// </exception>
+		public void Write(string path, long totalMilliseconds)
+		{
+			using var stream = new FileStream(path, FileMode.Create, FileAccess.Write, FileShare.None, OUTPUT_BUFFER_SIZE);
+			using var writer = new Utf8JsonWriter(stream, new() { Indented = true });
+
+			var files = _files.OrderBy(file => file.Path, StringComparer.Ordinal).ToList();
+
+			writer.WriteStartObject();
+			writer.WriteString("version", VERSION);
+			writer.WriteNumber("totalMilliseconds", totalMilliseconds);
+
+			writer.WriteStartObject("summary");
+			writer.WriteNumber("files", files.Count);
+			writer.WriteNumber("failures", files.Count(file => !file.Success));
+			writer.WriteNumber("cached", files.Count(file => file.Cached));
+			writer.WriteStartObject("stages");
+
+			foreach (var stage in Enum.GetValues<Stage>())
+			{
+				var measurements = files.Select(file => file.Stages[(int) stage]).OfType<StageMeasurement>().ToList();
+
+				if (measurements.Count <= 0)
+				{
+					continue;
+				}
+
+				writer.WriteStartObject(GetStageName(stage));
+				writer.WriteNumber("files", measurements.Count);
+
+				if (measurements.Any(measurement => measurement.Approximate))
+				{
+					writer.WriteBoolean("approximate", true);
+				}
+
+				WriteDistribution(writer, "milliseconds", measurements.Select(measurement => measurement.Milliseconds));
+				WriteDistribution(writer, "allocatedBytes", measurements.Select(measurement => (double) measurement.AllocatedBytes));
+				writer.WriteEndObject();
+			}
+
+			writer.WriteEndObject();
+			writer.WriteEndObject();
+
+			writer.WriteStartArray("files");
+
+			foreach (var file in files)
+			{
+				WriteFile(writer, file);
+			}
+
+			writer.WriteEndArray();
+			writer.WriteEndObject();
+		}
+
+		static private void WriteFile(Utf8JsonWriter writer, FileStatistics file)
+		{
+			writer.WriteStartObject();
+			writer.WriteString("path", file.Path);
+			writer.WriteBoolean("success", file.Success);
+			writer.WriteBoolean("cached", file.Cached);
+			writer.WriteString("game", file.Game.ToString());
+			writer.WriteNumber("fileSize", file.FileSize);
+
+			writer.WriteStartObject("counts");
+			writer.WriteNumber("code", file.CodeSize);
+			writer.WriteNumber("instructions", file.Instructions);
+			writer.WriteNumber("topLevelNodes", file.TopLevelNodes);
+			writer.WriteNumber("nodes", file.Nodes);
+			writer.WriteNumber("globalStrings", file.GlobalStrings);
+			writer.WriteNumber("functionStrings", file.FunctionStrings);
+			writer.WriteNumber("globalFloats", file.GlobalFloats);
+			writer.WriteNumber("functionFloats", file.FunctionFloats);
+			writer.WriteEndObject();
+
+			writer.WriteStartObject("stages");
+
+			foreach (var stage in Enum.GetValues<Stage>())
+			{
+				if (file.Stages[(int) stage] is StageMeasurement measurement)
+				{
+					writer.WriteStartObject(GetStageName(stage));
+					writer.WriteNumber("milliseconds", Math.Round(measurement.Milliseconds, 4));
+					writer.WriteNumber("allocatedBytes", measurement.AllocatedBytes);
+
+					if (measurement.Approximate)
+					{
+						writer.WriteBoolean("approximate", true);
+					}
+
+					writer.WriteEndObject();
+				}
+			}
+
+			writer.WriteEndObject();
+			writer.WriteEndObject();
+		}
+
+		/// <summary>
+		/// Writes the nearest-rank percentiles, max, and total of <paramref name="values"/>.
+		/// </summary>
+		static private void WriteDistribution(Utf8JsonWriter writer, string name, IEnumerable<double> values)
+		{
+			var sorted = values.Order().ToArray();
+
+			writer.WriteStartObject(name);
+
+			foreach (var percentile in _percentiles)
+			{
+				var rank = (int) Math.Ceiling(percentile / 100.0 * sorted.Length);
+
+				writer.WriteNumber($"p{percentile}", Math.Round(sorted[Math.Max(rank - 1, 0)], 4));
+			}
+
+			writer.WriteNumber("max", Math.Round(sorted[^1], 4));
+			writer.WriteNumber("total", Math.Round(sorted.Sum(), 4));
+			writer.WriteEndObject();
+		}
+
+		static private string GetStageName(Stage stage) => JsonNamingPolicy.CamelCase.ConvertName(stage.ToString());
+	}
+}
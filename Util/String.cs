@@ -8,6 +8,8 @@
  * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
  */
 
+using System.Buffers;
+
 namespace DSO.Util
 {
 	static public class String
@@ -54,22 +56,76 @@ namespace DSO.Util
 			{ "\xA0", "\\xA0" },
 		};
 
-		static public string EscapeChar(char ch) => EscapeString($"{ch}");
+		/// <summary>
+		/// <see cref="_escapeCharMap"/> indexed by character, so strings can be escaped in one pass. Nothing outside
+		/// of Latin-1 gets escaped.
+		/// </summary>
+		static private readonly string?[] _escapeTable = CreateEscapeTable();
+
+		static private readonly SearchValues<char> _escapeChars = SearchValues.Create(string.Concat(_escapeCharMap.Keys));
+
+		/// <summary>
+		/// The most characters a single character can be escaped into.
+		/// </summary>
+		static private readonly int _maxEscapeLength = _escapeCharMap.Values.Max(escape => escape.Length);
+
+		static public string EscapeChar(char ch) => ch < _escapeTable.Length && _escapeTable[ch] is string escape ? escape : ch.ToString();
+
 		static public string EscapeString(string str)
 		{
 			// Since tagged strings start with the 0x01 character, and \c0 maps to 0x01, any string
 			// that starts with \c0 automatically gets a 0x02 character prepended to avoid errors.
-			if (str.StartsWith("\x02\x01"))
+			// This has to be ordinal, since culture-sensitive comparisons ignore control characters entirely.
+			var span = str.StartsWith("\x02\x01", StringComparison.Ordinal) ? str.AsSpan(1) : str.AsSpan();
+			var index = span.IndexOfAny(_escapeChars);
+
+			// Most strings don't have anything to escape, so don't copy them.
+			if (index < 0)
 			{
-				str = str[1..];
+				return span.Length == str.Length ? str : span.ToString();
 			}
 
+			var buffer = ArrayPool<char>.Shared.Rent(index + (span.Length - index) * _maxEscapeLength);
+
+			try
+			{
+				span[..index].CopyTo(buffer);
+
+				var length = index;
+
+				for (; index < span.Length; index++)
+				{
+					var ch = span[index];
+
+					if (ch < _escapeTable.Length && _escapeTable[ch] is string escape)
+					{
+						escape.CopyTo(buffer.AsSpan(length));
+						length += escape.Length;
+					}
+					else
+					{
+						buffer[length++] = ch;
+					}
+				}
+
+				return new(buffer, 0, length);
+			}
+			finally
+			{
+				ArrayPool<char>.Shared.Return(buffer);
+			}
+		}
+
+		static private string?[] CreateEscapeTable()
+		{
+			var table = new string?[256];
+
 			foreach (var (find, replace) in _escapeCharMap)
 			{
-				str = str.Replace(find, replace);
+				table[find[0]] = replace;
 			}
 
-			return str;
+			return table;
 		}
 	}
 }
@@ -0,0 +1,454 @@
+﻿/**
+ * SymbolIndex.cs
+ *
+ * Copyright (C) 2024 Elletra
+ *
+ * This file is part of the DSO Sharp source code. It may be used under the BSD 3-Clause License.
+ *
+ * For full terms, see the LICENSE file or visit https://spdx.org/licenses/BSD-3-Clause.html
+ */
+
+using DSO.AST.Nodes;
+using DSO.Disassembler;
+using DSO.Versions;
+using System.Collections.Concurrent;
+using System.Text.Json;
+
+using static DSO.Constants.Decompiler;
+
+namespace DSO.Util
+{
+	public class FunctionSymbol(string name, string? ns, string? package, uint address, int arguments)
+	{
+		public readonly string Name = name;
+		public readonly string? Namespace = ns;
+		public readonly string? Package = package;
+		public readonly uint Address = address;
+		public readonly int Arguments = arguments;
+
+		public string FullName => Namespace != null ? $"{Namespace}::{Name}" : Name;
+	}
+
+	/// <summary>
+	/// All calls from the same place to the same function are merged into one, with a count.
+	/// </summary>
+	public class CallSymbol(int caller, string name, string? ns, CallType type, int count)
+	{
+		/// <summary>
+		/// Index of the function the call is in, or -1 if it's at the top level of the file.
+		/// </summary>
+		public readonly int Caller = caller;
+
+		public readonly string Name = name;
+		public readonly string? Namespace = ns;
+		public readonly CallType Type = type;
+		public readonly int Count = count;
+
+		/// <summary>
+		/// Method calls don't know their namespace until runtime, so they're only known by their name.
+		/// </summary>
+		public string FullName => Namespace != null && Type != CallType.MethodCall ? $"{Namespace}::{Name}" : Name;
+	}
+
+	public class FileSymbols(string path, long size, long modified, GameIdentifier game, List<FunctionSymbol> functions, List<CallSymbol> calls)
+	{
+		private const int TOP_LEVEL = -1;
+
+		/// <summary>
+		/// Calls in the body of a function with no name are left out, since they'd be attributed to the wrong place.
+		/// </summary>
+		private const int UNNAMED_FUNCTION = -2;
+
+		/// <summary>
+		/// Collects the function declarations and calls in a file. Calls are attributed to whichever function body
+		/// they're in, the same way <see cref="BytecodeReader"/> keeps track of it.
+		/// </summary>
+		static public FileSymbols Create(string path, long size, long modified, GameIdentifier game, Disassembly disassembly)
+		{
+			var functions = new List<FunctionSymbol>();
+			var calls = new Dictionary<(int, string, string?, CallType), int>();
+			var caller = TOP_LEVEL;
+			var endAddress = 0u;
+
+			foreach (var instruction in disassembly)
+			{
+				if (caller != TOP_LEVEL && instruction.Address >= endAddress)
+				{
+					caller = TOP_LEVEL;
+				}
+
+				// Broken files can have functions and calls with no name, and there's nothing to look those up by.
+				switch (instruction)
+				{
+					case FunctionInstruction function:
+					{
+						var index = UNNAMED_FUNCTION;
+
+						if (function.Name?.Value is string name)
+						{
+							functions.Add(new(name, function.Namespace?.Value, function.Package?.Value, function.Address, function.Arguments.Count));
+							index = functions.Count - 1;
+						}
+
+						if (function.HasBody)
+						{
+							caller = index;
+							endAddress = function.EndAddress;
+						}
+
+						break;
+					}
+
+					case CallInstruction call when caller != UNNAMED_FUNCTION && call.Name?.Value is string name:
+					{
+						var key = (caller, name, call.Namespace?.Value, FunctionCallNode.GetCallType(call.CallType));
+
+						calls[key] = calls.GetValueOrDefault(key) + 1;
+						break;
+					}
+				}
+			}
+
+			return new(path, size, modified, game, functions,
+				calls.Select(call => new CallSymbol(call.Key.Item1, call.Key.Item2, call.Key.Item3, call.Key.Item4, call.Value)).ToList());
+		}
+
+		/// <summary>
+		/// Relative to the directory the index is in.
+		/// </summary>
+		public readonly string Path = path;
+
+		/// <summary>
+		/// The size and last write time (in UTC ticks) of the file when it was indexed, or 0 for files that
+		/// didn't come from the disk.
+		/// </summary>
+		public readonly long Size = size;
+		public readonly long Modified = modified;
+
+		public readonly GameIdentifier Game = game;
+		public readonly List<FunctionSymbol> Functions = functions;
+		public readonly List<CallSymbol> Calls = calls;
+	}
+
+	/// <summary>
+	/// An index of every function declared in a set of files and every call made to them, so that finding where
+	/// something is defined or who calls it doesn't mean decompiling everything.<br/><br/>
+	///
+	/// The index is written as JSON. Each file's entry keeps the size and last write time of the file, so that
+	/// the next run over the same files can reuse the entries of the files that haven't changed.
+	/// </summary>
+	public class SymbolIndex
+	{
+		static private readonly Dictionary<string, CallType> _callTypes = new()
+		{
+			{ "function", CallType.FunctionCall },
+			{ "method", CallType.MethodCall },
+			{ "parent", CallType.ParentCall },
+			{ "invalid", CallType.Invalid },
+		};
+
+		/// <summary>
+		/// Loads the index at <paramref name="indexPath"/> if there is one. Entries from a different version of this
+		/// program are thrown out, since they might have been read differently.
+		/// </summary>
+		static public SymbolIndex Load(string indexPath)
+		{
+			var index = new SymbolIndex(indexPath);
+
+			if (!File.Exists(index._indexPath))
+			{
+				return index;
+			}
+
+			try
+			{
+				using var document = JsonDocument.Parse(File.ReadAllBytes(index._indexPath));
+
+				var root = document.RootElement;
+
+				if (root.GetProperty("version").GetString() != VERSION)
+				{
+					return index;
+				}
+
+				foreach (var file in root.GetProperty("files").EnumerateArray())
+				{
+					var entry = ReadFile(file);
+
+					index._files[entry.Path] = entry;
+				}
+			}
+			catch (Exception exception)
+			{
+				// A missing or broken index just means everything gets indexed again.
+				Logger.LogWarning($"Could not read index file \"{index._indexPath}\": {exception.Message}");
+				index._files.Clear();
+			}
+
+			return index;
+		}
+
+		private readonly string _indexPath;
+		private readonly string _root;
+		private readonly ConcurrentDictionary<string, FileSymbols> _files = new();
+
+		/// <summary>
+		/// The files that were seen this time around, whether or not they changed.
+		/// </summary>
+		private readonly ConcurrentDictionary<string, bool> _seen = new();
+
+		private SymbolIndex(string indexPath)
+		{
+			_indexPath = Path.GetFullPath(indexPath);
+			_root = Path.GetDirectoryName(_indexPath)!;
+		}
+
+		public bool IsUpToDate(string path)
+		{
+			var relativePath = GetRelativePath(path);
+
+			if (!_files.TryGetValue(relativePath, out FileSymbols? entry))
+			{
+				return false;
+			}
+
+			var info = new FileInfo(path);
+
+			if (!info.Exists || info.Length != entry.Size || info.LastWriteTimeUtc.Ticks != entry.Modified)
+			{
+				return false;
+			}
+
+			_seen[relativePath] = true;
+
+			return true;
+		}
+
+		/// <param name="fromDisk">Whether <paramref name="path"/> is a real file, and not something like an archive entry.</param>
+		public void Update(string path, GameIdentifier game, Disassembly disassembly, bool fromDisk)
+		{
+			var relativePath = GetRelativePath(path);
+			var info = fromDisk ? new FileInfo(path) : null;
+
+			_files[relativePath] = FileSymbols.Create(relativePath, info?.Length ?? 0, info?.LastWriteTimeUtc.Ticks ?? 0, game, disassembly);
+			_seen[relativePath] = true;
+		}
+
+		/// <summary>
+		/// Drops the entry for a file that couldn't be indexed, so a stale entry from before it changed doesn't get
+		/// saved as if it were still right.
+		/// </summary>
+		public void Remove(string path) => _files.TryRemove(GetRelativePath(path), out _);
+
+		/// <summary>
+		/// Writes the index to a temporary file first and then moves it into place, same as <see cref="OutputCache"/>.
+		/// Entries for files that weren't seen this time and don't exist anymore are dropped.
+		/// </summary>
+		/// <exception cref="IOException">
+		/// Throws if the file could not be written.
+		/// </exception>
+		public void Save()
+		{
+			var files = _files.Values
+				.Where(file => _seen.ContainsKey(file.Path) || Exists(Path.Join(_root, file.Path)))
+				.OrderBy(file => file.Path, StringComparer.Ordinal)
+				.ToList();
+
+			var tempPath = $"{_indexPath}{TEMP_EXTENSION}";
+
+			try
+			{
+				using (var stream = new FileStream(tempPath, FileMode.Create, FileAccess.Write, FileShare.None, OUTPUT_BUFFER_SIZE))
+				{
+					using var writer = new Utf8JsonWriter(stream);
+
+					Write(writer, files);
+				}
+
+				File.Move(tempPath, _indexPath, overwrite: true);
+			}
+			catch (Exception)
+			{
+				File.Delete(tempPath);
+				throw;
+			}
+		}
+
+		static private void Write(Utf8JsonWriter writer, List<FileSymbols> files)
+		{
+			writer.WriteStartObject();
+			writer.WriteString("version", VERSION);
+
+			writer.WriteStartArray("files");
+
+			foreach (var file in files)
+			{
+				WriteFile(writer, file);
+			}
+
+			writer.WriteEndArray();
+
+			// Function names in TorqueScript aren't case-sensitive, so neither are these.
+			var symbols = new Dictionary<string, List<(int File, int Function)>>(StringComparer.OrdinalIgnoreCase);
+			var callers = new Dictionary<string, List<(int File, int Call)>>(StringComparer.OrdinalIgnoreCase);
+
+			for (var fileIndex = 0; fileIndex < files.Count; fileIndex++)
+			{
+				var file = files[fileIndex];
+
+				for (var i = 0; i < file.Functions.Count; i++)
+				{
+					GetList(symbols, file.Functions[i].FullName).Add((fileIndex, i));
+				}
+
+				for (var i = 0; i < file.Calls.Count; i++)
+				{
+					GetList(callers, file.Calls[i].FullName).Add((fileIndex, i));
+				}
+			}
+
+			writer.WriteStartObject("symbols");
+
+			foreach (var (name, locations) in symbols.OrderBy(symbol => symbol.Key, StringComparer.OrdinalIgnoreCase))
+			{
+				writer.WriteStartArray(name);
+
+				foreach (var (fileIndex, function) in locations)
+				{
+					writer.WriteStartArray();
+					writer.WriteNumberValue(fileIndex);
+					writer.WriteNumberValue(function);
+					writer.WriteEndArray();
+				}
+
+				writer.WriteEndArray();
+			}
+
+			writer.WriteEndObject();
+
+			writer.WriteStartObject("callers");
+
+			foreach (var (name, locations) in callers.OrderBy(caller => caller.Key, StringComparer.OrdinalIgnoreCase))
+			{
+				writer.WriteStartArray(name);
+
+				foreach (var (fileIndex, call) in locations)
+				{
+					writer.WriteStartArray();
+					writer.WriteNumberValue(fileIndex);
+					writer.WriteNumberValue(files[fileIndex].Calls[call].Caller);
+					writer.WriteEndArray();
+				}
+
+				writer.WriteEndArray();
+			}
+
+			writer.WriteEndObject();
+			writer.WriteEndObject();
+		}
+
+		static private void WriteFile(Utf8JsonWriter writer, FileSymbols file)
+		{
+			writer.WriteStartObject();
+			writer.WriteString("path", file.Path);
+			writer.WriteNumber("size", file.Size);
+			writer.WriteNumber("modified", file.Modified);
+			writer.WriteString("game", file.Game.ToString());
+
+			writer.WriteStartArray("functions");
+
+			foreach (var function in file.Functions)
+			{
+				writer.WriteStartObject();
+				writer.WriteString("name", function.Name);
+				WriteOptionalString(writer, "namespace", function.Namespace);
+				WriteOptionalString(writer, "package", function.Package);
+				writer.WriteNumber("address", function.Address);
+				writer.WriteNumber("arguments", function.Arguments);
+				writer.WriteEndObject();
+			}
+
+			writer.WriteEndArray();
+
+			writer.WriteStartArray("calls");
+
+			foreach (var call in file.Calls)
+			{
+				writer.WriteStartObject();
+				writer.WriteNumber("caller", call.Caller);
+				writer.WriteString("name", call.Name);
+				WriteOptionalString(writer, "namespace", call.Namespace);
+				writer.WriteString("type", _callTypes.First(type => type.Value == call.Type).Key);
+				writer.WriteNumber("count", call.Count);
+				writer.WriteEndObject();
+			}
+
+			writer.WriteEndArray();
+			writer.WriteEndObject();
+		}
+
+		static private FileSymbols ReadFile(JsonElement file)
+		{
+			var functions = file.GetProperty("functions").EnumerateArray().Select(function => new FunctionSymbol(
+				function.GetProperty("name").GetString()!,
+				ReadOptionalString(function, "namespace"),
+				ReadOptionalString(function, "package"),
+				function.GetProperty("address").GetUInt32(),
+				function.GetProperty("arguments").GetInt32())).ToList();
+
+			var calls = file.GetProperty("calls").EnumerateArray().Select(call => new CallSymbol(
+				call.GetProperty("caller").GetInt32(),
+				call.GetProperty("name").GetString()!,
+				ReadOptionalString(call, "namespace"),
+				_callTypes[call.GetProperty("type").GetString()!],
+				call.GetProperty("count").GetInt32())).ToList();
+
+			return new(
+				file.GetProperty("path").GetString()!,
+				file.GetProperty("size").GetInt64(),
+				file.GetProperty("modified").GetInt64(),
+				Enum.Parse<GameIdentifier>(file.GetProperty("game").GetString()!),
+				functions,
+				calls);
+		}
+
+		static private void WriteOptionalString(Utf8JsonWriter writer, string name, string? value)
+		{
+			if (value != null)
+			{
+				writer.WriteString(name, value);
+			}
+		}
+
+		static private string? ReadOptionalString(JsonElement element, string name) => element.TryGetProperty(name, out JsonElement value) ? value.GetString() : null;
+
+		static private List<T> GetList<T>(Dictionary<string, List<T>> lists, string name)
+		{
+			if (!lists.TryGetValue(name, out List<T>? list))
+			{
+				list = [];
+				lists[name] = list;
+			}
+
+			return list;
+		}
+
+		/// <summary>
+		/// Files inside of an archive count as existing as long as the archive does.
+		/// </summary>
+		static private bool Exists(string path)
+		{
+			for (var current = path; !string.IsNullOrEmpty(current); current = Path.GetDirectoryName(current))
+			{
+				if (File.Exists(current))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		private string GetRelativePath(string path) => Path.GetRelativePath(_root, Path.GetFullPath(path)).Replace('\\', '/');
+	}
+}
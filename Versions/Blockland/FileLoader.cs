@@ -9,22 +9,49 @@
  */
 
 using DSO.Loader;
+using System.Numerics;
 
 namespace DSO.Versions.Blockland
 {
     public class FileLoader : Loader.FileLoader
     {
-		static private string UnencryptString(string str)
+		static private readonly byte[] _key = "cl3buotro"u8.ToArray();
+
+		/// <summary>
+		/// The key repeated to fill exactly <see cref="_key"/>.Length vectors, so that every vector-sized chunk of
+		/// a string lines up with a chunk of this.
+		/// </summary>
+		static private readonly byte[] _keyStream = Enumerable.Range(0, _key.Length * Vector<byte>.Count)
+			.Select(i => _key[i % _key.Length])
+			.ToArray();
+
+		/// <summary>
+		/// Blockland string tables are XOR'd with a repeating key.
+		/// </summary>
+		static private void UnencryptString(Span<byte> bytes)
 		{
-			var key = "cl3buotro";
-			var unencrypted = "";
+			var width = Vector<byte>.Count;
+			var i = 0;
 
-			for (var i = 0; i < str.Length; i++)
+			if (Vector.IsHardwareAccelerated)
 			{
-				unencrypted += (char) (str[i] ^ key[i % 9]);
+				for (var keyIndex = 0; i <= bytes.Length - width; i += width, keyIndex += width)
+				{
+					if (keyIndex >= _keyStream.Length)
+					{
+						keyIndex = 0;
+					}
+
+					var chunk = bytes.Slice(i, width);
+
+					(new Vector<byte>(chunk) ^ new Vector<byte>(_keyStream, keyIndex)).CopyTo(chunk);
+				}
 			}
 
-			return unencrypted;
+			for (; i < bytes.Length; i++)
+			{
+				bytes[i] ^= _key[i % _key.Length];
+			}
 		}
 
 		protected override void ReadTables(FileData data)
@@ -37,7 +64,7 @@ namespace DSO.Versions.Blockland
 
 		protected override void ReadStringTable(FileData data, bool global)
 		{
-			var table = new StringTable(UnencryptString(_reader.ReadString()), global);
+			var table = new StringTable(_reader.ReadString(UnencryptString), global);
 
 			if (global)
 			{
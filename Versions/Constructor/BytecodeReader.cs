@@ -22,5 +22,10 @@ namespace DSO.Versions.Constructor
 		protected override Instruction ReadInstruction(uint address, Opcode? opcode) => opcode?.Tag == OpcodeTag.OP_CREATE_OBJECT
 			? new CreateObjectInstruction(opcode, address, this)
 			: base.ReadInstruction(address, opcode);
+
+		// Torque Constructor has an extra `isInternal` operand.
+		protected override uint? GetOperandCount(OpcodeTag tag, uint address) => tag == OpcodeTag.OP_CREATE_OBJECT
+			? 4
+			: base.GetOperandCount(tag, address);
 	}
 }
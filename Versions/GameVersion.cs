@@ -11,6 +11,7 @@
 using DSO.Disassembler;
 using DSO.Loader;
 using DSO.Opcodes;
+using System.Collections.Concurrent;
 
 using static DSO.Constants.Decompiler;
 
@@ -31,8 +32,29 @@ namespace DSO.Versions
 
 	public class GameVersion
 	{
-		static public bool IsValidGame(GameIdentifier identifier) => Enum.IsDefined(typeof(GameIdentifier), identifier)
-			&& identifier != GameIdentifier.Auto;
+		/// <summary>
+		/// Every supported game, listed out instead of going through <see cref="Enum"/>, since that relies on
+		/// reflection and is slow the first time it's used (especially with AOT).
+		/// </summary>
+		static public readonly GameIdentifier[] Games =
+		[
+			GameIdentifier.TGE10,
+			GameIdentifier.TGE14,
+			GameIdentifier.TCON,
+			GameIdentifier.Tribes2,
+			GameIdentifier.ForgettableDungeon,
+			GameIdentifier.BlocklandV1,
+			GameIdentifier.BlocklandV20,
+			GameIdentifier.BlocklandV21,
+		];
+
+		static public bool IsValidGame(GameIdentifier identifier) => identifier switch
+		{
+			GameIdentifier.TGE10 or GameIdentifier.TGE14 or GameIdentifier.TCON or GameIdentifier.Tribes2
+				or GameIdentifier.ForgettableDungeon or GameIdentifier.BlocklandV1 or GameIdentifier.BlocklandV20
+				or GameIdentifier.BlocklandV21 => true,
+			_ => false,
+		};
 
 		static public string GetDisplayName(GameIdentifier identifier) => identifier switch
 		{
@@ -87,6 +109,14 @@ namespace DSO.Versions
 			_ => null,
 		};
 
+		/// <summary>
+		/// Ops never change once they're created, so each game only ever needs one instance, which gets shared
+		/// between every file and thread.
+		/// </summary>
+		static private readonly ConcurrentDictionary<GameIdentifier, Ops> _ops = [];
+
+		static public Ops? GetOps(GameIdentifier identifier) => IsValidGame(identifier) ? _ops.GetOrAdd(identifier, id => CreateOps(id)!) : null;
+
 		static public FileLoader? CreateFileLoader(GameIdentifier identifier) => identifier switch
 		{
 			GameIdentifier.Auto => null,
@@ -112,7 +142,7 @@ namespace DSO.Versions
 			Identifier = identifier,
 			DisplayName = GetDisplayName(identifier),
 			Version = GetVersionFromIdentifier(identifier),
-			Ops = CreateOps(identifier),
+			Ops = GetOps(identifier),
 			FileLoader = CreateFileLoader(identifier),
 		};
 
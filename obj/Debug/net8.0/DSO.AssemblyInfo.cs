@@ -0,0 +1,23 @@
+//------------------------------------------------------------------------------
+// <auto-generated>
+//     This code was generated by a tool.
+//
+//     Changes to this file may cause incorrect behavior and will be lost if
+//     the code is regenerated.
+// </auto-generated>
+//------------------------------------------------------------------------------
+
+using System;
+using System.Reflection;
+
+[assembly: System.Reflection.AssemblyCompanyAttribute("Elletra")]
+[assembly: System.Reflection.AssemblyConfigurationAttribute("Debug")]
+[assembly: System.Reflection.AssemblyDescriptionAttribute("A DSO decompiler for the Torque Game Engine.")]
+[assembly: System.Reflection.AssemblyFileVersionAttribute("2.1.0")]
+[assembly: System.Reflection.AssemblyInformationalVersionAttribute("2.1.0+fd88dc4b5eead1be054e797cf7e6d8e7edc90a1e")]
+[assembly: System.Reflection.AssemblyProductAttribute("DSO Sharp")]
+[assembly: System.Reflection.AssemblyTitleAttribute("dso-sharp")]
+[assembly: System.Reflection.AssemblyVersionAttribute("2.1.0")]
+
+// Generated by the MSBuild WriteCodeFragment class.
+